@@ -0,0 +1,146 @@
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include "cloth.hpp"
+#include "colliders.hpp"
+#include "replay.hpp"
+#include "simulation.hpp"
+
+// steps a scene of falling bodies and cloths without a window or gl,
+// usage: sim_bench [--bodies N] [--frames M] [--threads T] [--cloths C]
+namespace {
+    struct BenchOptions {
+        uint32_t    bodies{ 1000 };
+        uint32_t    frames{ 600 };
+        // 0 uses all hardware threads
+        uint32_t    threads{ 0 };
+        uint32_t    cloths{ 0 };
+    };
+
+    bool parse_options(int argc, char** argv, BenchOptions& options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg{ argv[i] };
+            uint32_t* value{ nullptr };
+            if (arg == "--bodies") {
+                value = &options.bodies;
+            }
+            else if (arg == "--frames") {
+                value = &options.frames;
+            }
+            else if (arg == "--threads") {
+                value = &options.threads;
+            }
+            else if (arg == "--cloths") {
+                value = &options.cloths;
+            }
+
+            if (!value || i + 1 >= argc) {
+                std::cerr << "usage: sim_bench [--bodies N] [--frames M] [--threads T] [--cloths C]\n";
+                return false;
+            }
+            const std::string_view number{ argv[++i] };
+            if (std::from_chars(number.data(), number.data() + number.size(), *value).ec != std::errc{}) {
+                std::cerr << "not a number: " << number << '\n';
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void print_phase(const char* name, my_gl::Duration_sec duration, uint32_t frames) {
+        std::cout << "  " << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << duration.count() * 1000.0f << " ms"
+            << std::setw(10) << duration.count() * 1000.0f / frames << " ms/frame\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parse_options(argc, argv, options) || options.frames == 0) {
+        return 1;
+    }
+
+    my_gl::Simulation simulation{ my_gl::FixedTimestep{ 60.0f, 8 }, options.threads };
+    my_gl::PhysicsWorld& world{ simulation._physics_world };
+    world.reserve(options.bodies + 1);
+
+    // floor under a square grid of bodies, every other one a sphere
+    uint32_t side{ 1 };
+    while (side * side < options.bodies) {
+        ++side;
+    }
+    const float spacing{ 1.5f };
+    const float half_floor{ side * spacing * 0.5f + 1.0f };
+    const my_gl::BodyId floor{ world.add_body({ 0.0f, -1.0f, 0.0f }, {}, {}, 0.0f) };
+    world.set_collider(floor, my_gl::Collider::box({ half_floor, 1.0f, half_floor }));
+
+    for (uint32_t i = 0; i < options.bodies; ++i) {
+        const uint32_t column{ i % side };
+        const uint32_t row{ i / side };
+        const my_gl::math::Vec3<float> position{
+            (column - side * 0.5f) * spacing,
+            1.0f + (i % 7) * 0.6f,
+            (row - side * 0.5f) * spacing,
+        };
+        const my_gl::BodyId body{ world.add_body(position, {}, { 0.0f, -9.81f, 0.0f }, 1.0f) };
+        world.set_collider(body, i % 2 == 0
+            ? my_gl::Collider::box({ 0.5f, 0.5f, 0.5f })
+            : my_gl::Collider::sphere(0.5f)
+        );
+    }
+
+    std::vector<my_gl::Cloth> cloths;
+    cloths.reserve(options.cloths);
+    for (uint32_t i = 0; i < options.cloths; ++i) {
+        cloths.push_back(my_gl::Cloth::grid(64, 64, 0.05f, { i * 4.0f, 10.0f, 0.0f }));
+    }
+    simulation._cloths = cloths;
+
+    const my_gl::Duration_sec frame_time{ 1.0f / 60.0f };
+    // by CollisionEvent::Type
+    uint64_t event_counts[3]{ 0, 0, 0 };
+    const auto start{ std::chrono::steady_clock::now() };
+    for (uint32_t frame = 0; frame < options.frames; ++frame) {
+        simulation.advance(frame_time);
+        for (const my_gl::CollisionEvent& event : simulation._collision_events) {
+            ++event_counts[static_cast<std::size_t>(event.type)];
+        }
+    }
+    const my_gl::Duration_sec total{ std::chrono::steady_clock::now() - start };
+
+    // same options must give the same hash for any thread count
+    uint64_t hash{ my_gl::FNV_OFFSET_BASIS };
+    for (my_gl::BodyId body = 0; body < world.size(); ++body) {
+        const my_gl::math::Vec3<float> position{ world.position(body) };
+        const float xyz[3]{ position[0], position[1], position[2] };
+        hash = my_gl::fnv1a(xyz, sizeof(xyz), hash);
+    }
+    for (auto& cloth : cloths) {
+        const my_gl::meshes::Mesh mesh{ cloth.mesh() };
+        hash = my_gl::fnv1a(mesh.vertices.data(), sizeof(float) * mesh.vertices.size(), hash);
+    }
+
+    const my_gl::SimulationTimings& timings{ simulation._timings };
+    const my_gl::PhysicsTimings& physics{ world._timings };
+    std::cout << options.bodies << " bodies, " << options.cloths << " cloths, " << options.frames << " frames, "
+        << simulation._thread_pool.size() << " threads\n";
+    print_phase("total", total, options.frames);
+    print_phase("physics", timings.physics, options.frames);
+    print_phase(" integrate", physics.integrate, options.frames);
+    print_phase(" broadphase", physics.broadphase, options.frames);
+    print_phase(" narrowphase", physics.narrowphase, options.frames);
+    print_phase(" solver", physics.solver, options.frames);
+    print_phase(" events", physics.events, options.frames);
+    print_phase("cloths", timings.cloths, options.frames);
+    print_phase("scene query", timings.scene_query, options.frames);
+    print_phase("animations", timings.animations, options.frames);
+    std::cout << "collision events: begin " << event_counts[0] << ", persist " << event_counts[1] << ", end " << event_counts[2]
+        << ", overwritten " << world._events.overwritten() << '\n';
+    std::cout << "contacts " << world.contacts().size() << ", state hash " << std::hex << hash << std::dec << '\n';
+
+    return 0;
+}
@@ -259,9 +259,10 @@ namespace my_gl {
             if (_loop == Loop_type::NONE && _is_ended) {
                 return _mat;
             }
+            // time only moves by frame durations passed to update_time,
+            // so replaying the same durations gives the same frames
             if (!_is_started) {
-                _start_time = std::chrono::steady_clock::now();
-                _curr_time = _start_time;
+                _start_time = _curr_time;
                 _is_started = true;
             }
 
@@ -270,8 +271,7 @@ namespace my_gl {
 
             if (_delay.count() > 0.0f && !_is_delay_passed) {
                 if (passed_time.count() >= _delay.count()) {
-                    _start_time = std::chrono::steady_clock::now();
-                    _curr_time = _start_time;
+                    _start_time = _curr_time;
                     _is_delay_passed = true;
                 }
                 else {
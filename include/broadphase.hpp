@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "collision.hpp"
+#include "physicsTypes.hpp"
+
+namespace my_gl {
+    // sweep and prune along the axis awake bodies are spread the most on,
+    // in bands across the second most spread one, so a row of bodies
+    // lined up along the sweep axis isn't walked by every body of it,
+    // sorted order is kept between steps, bodies move little per step
+    // so insertion sort is almost linear,
+    // sleeping and static bodies are kept sorted apart, they aren't sorted or swept
+    // until that set changes, awake bodies look them up by binary search
+    class Broadphase {
+    public:
+        // outputs pairs with bounds closer than margin sorted by pair key,
+        // pairs without an awake body are skipped (static bodies are never awake)
+        void find_pairs(
+            const SoAVec3&              bounds_min,
+            const SoAVec3&              bounds_max,
+            const std::vector<float>&   awake,
+            float                       margin,
+            std::vector<BodyPair>&      out_pairs
+        );
+        // body woke up, it is swept again from the next find_pairs on
+        void wake(BodyId body);
+        // bounds of a body were set, not moved by the integration
+        void bounds_changed(BodyId body);
+
+    private:
+        // bounds copied next to each other in sweep order, so the sweep reads memory in order
+        struct Proxy {
+            float       min[3]{};
+            float       max[3]{};
+            BodyId      body{ 0 };
+            // first band of the body, a pair is reported only in the first band both are in
+            uint32_t    band{ 0 };
+        };
+
+        // moves bodies which woke up or fell asleep between the lists, adds new ones,
+        // returns count of awake proxies still in the order of the last step, the rest is appended
+        std::size_t update_lists(const SoAVec3& bounds_min, const SoAVec3& bounds_max, const std::vector<float>& awake);
+        bool        choose_axes();
+        void        sort_proxies(std::vector<Proxy>& proxies, std::size_t sorted_count, bool is_resorted) const;
+        void        update_band_layout(float margin);
+        void        fill_bands(std::vector<Proxy>& proxies, float margin, std::vector<Proxy>& band_proxies, std::vector<uint32_t>& band_starts);
+        void        split_sleeping();
+        uint32_t    band_of(float coord) const;
+        void        sweep_awake(float margin, std::vector<BodyPair>& out_pairs) const;
+        void        sweep_sleeping(float margin, std::vector<BodyPair>& out_pairs) const;
+        bool        overlaps(const Proxy& a, const Proxy& b, float margin) const;
+
+        std::vector<Proxy>      _awake_proxies;
+        // static and sleeping bodies, sorted whenever they change
+        std::vector<Proxy>      _sleeping_proxies;
+        // sleeping ones longer than a few bands on the sweep axis, they find the awake ones themselves
+        std::vector<Proxy>      _large_proxies;
+        // longest regular sleeping body on the sweep axis, bounds the lookup of awake ones
+        float                   _sleeping_max_extent{ 0.0f };
+        float                   _awake_max_extent{ 0.0f };
+        // by body, 1 while it is in _awake_proxies
+        std::vector<uint8_t>    _is_listed_awake;
+        std::vector<BodyId>     _woken;
+        // bounds of sleeping ones were set, they are copied and sorted again
+        bool                    _is_sleeping_dirty{ false };
+        bool                    _is_sleeping_removed{ false };
+        // sleeping bodies are appended here, and merged in at once
+        std::vector<Proxy>      _fell_asleep;
+        // sleeping ones below the large size, copied into the bands
+        std::vector<Proxy>      _regular_proxies;
+
+        uint32_t                _axis{ 0 };
+        uint32_t                _band_axis{ 2 };
+        float                   _band_origin{ 0.0f };
+        float                   _band_width{ 1.0f };
+        uint32_t                _band_count{ 1 };
+        // proxies of band i are [starts[i], starts[i + 1]), in sweep order,
+        // bodies spanning more bands are copied into each of them,
+        // starts begin as the single empty band, a world stepped before any body is added sweeps that
+        std::vector<Proxy>      _awake_band_proxies;
+        std::vector<uint32_t>   _awake_band_starts{ 0, 0 };
+        std::vector<Proxy>      _sleeping_band_proxies;
+        std::vector<uint32_t>   _sleeping_band_starts{ 0, 0 };
+        // scratch of fill_bands and update_band_layout
+        std::vector<uint32_t>   _band_fill;
+        std::vector<float>      _extents;
+    };
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "meshes.hpp"
+#include "physicsTypes.hpp"
+#include "vec.hpp"
+
+namespace my_gl {
+    class ThreadPool;
+
+    struct ClothSettings {
+        math::Vec3<float>   gravity{ 0.0f, -9.81f, 0.0f };
+        // part of the velocity lost every step
+        float               damping{ 0.01f };
+        // more iterations make constraints stiffer
+        uint32_t            iterations{ 8 };
+    };
+
+    // verlet particles held together by distance constraints, position based,
+    // cloth is a grid of them, any other network of particles makes a soft body,
+    // it has no gl state, its vertices are streamed into a dynamic VertexArray
+    class Cloth {
+    public:
+        // grid in the xy plane hanging down from origin, top row is pinned,
+        // structural, shear and bending constraints, two triangles per cell
+        static Cloth grid(uint32_t width, uint32_t height, float spacing, const math::Vec3<float>& origin);
+
+        uint32_t            add_particle(const math::Vec3<float>& position, float inv_mass = 1.0f);
+        // rest length is the current distance between the particles,
+        // stiffness in [0, 1] is the part of the error fixed per iteration
+        void                add_constraint(uint32_t a, uint32_t b, float stiffness = 1.0f);
+        // counter clockwise, used for rendering and normals only
+        void                add_triangle(uint32_t a, uint32_t b, uint32_t c);
+        // pinned particles don't move unless moved by set_position
+        void                pin(uint32_t particle, bool pinned = true);
+        // teleports the particle, it keeps no velocity
+        void                set_position(uint32_t particle, const math::Vec3<float>& position);
+
+        void                step(float step_duration);
+        // positions then normals, as separate blocks, like the meshes in meshes.hpp
+        void                update_vertices();
+        // view over vertices and indices of the cloth, valid until particles or triangles are added
+        meshes::Mesh        mesh();
+
+        math::Vec3<float>   position(uint32_t particle) const { return { _pos[0][particle], _pos[1][particle], _pos[2][particle] }; }
+        uint32_t            size() const { return static_cast<uint32_t>(_inv_mass.size()); }
+        // byte offset of the normals block in the vertices
+        std::size_t         normal_byte_offset() const { return sizeof(float) * 3 * size(); }
+
+        ClothSettings       _settings;
+
+    private:
+        struct Constraint {
+            uint32_t    a;
+            uint32_t    b;
+            float       rest_length;
+            float       stiffness;
+        };
+
+        // constraints sharing no particle, so a simd lane never writes
+        // a particle another lane of the same batch reads
+        struct Batch {
+            std::vector<uint32_t>   a;
+            std::vector<uint32_t>   b;
+            std::vector<float>      rest_length;
+            // stiffness split by inverse masses, 0 for pinned particles
+            std::vector<float>      weight_a;
+            std::vector<float>      weight_b;
+        };
+
+        void                integrate(float step_duration);
+        void                relax_batch(const Batch& batch);
+        void                build_batches();
+
+        SoAVec3                     _pos;
+        SoAVec3                     _prev_pos;
+        std::vector<float>          _inv_mass;
+        // 1 for free particles, 0 for pinned ones
+        std::vector<float>          _free;
+        std::vector<Constraint>     _constraints;
+        std::vector<Batch>          _batches;
+        bool                        _batches_dirty{ true };
+        std::vector<float>          _vertices;
+        std::vector<uint16_t>       _indices;
+    };
+
+    // cloths are independent, each one is a task on the pool if given
+    void step_cloths(std::span<Cloth> cloths, float step_duration, ThreadPool* thread_pool = nullptr);
+}
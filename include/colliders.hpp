@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include "collision.hpp"
+#include "vec.hpp"
+
+namespace my_gl {
+    // collision shape of a body, independent from its render mesh,
+    // bodies don't rotate, so shapes are only offset by the body position
+    struct Collider {
+        enum class Type : uint8_t {
+            SPHERE,
+            CAPSULE,
+            BOX,
+            CONVEX_HULL,
+        };
+
+        Type                                type{ Type::BOX };
+        // shape center relative to the body position
+        math::Vec3<float>                   center{ 0.0f, 0.0f, 0.0f };
+        // box only, negative for an empty box which never collides
+        math::Vec3<float>                   half_extents = math::Vec3<float>(std::numeric_limits<float>::lowest());
+        // sphere and capsule
+        float                               radius{ 0.0f };
+        // capsule segment runs from center - axis * half_height to center + axis * half_height
+        math::Vec3<float>                   axis{ 0.0f, 1.0f, 0.0f };
+        float                               half_height{ 0.0f };
+        // points relative to center, storage is owned by the caller and must outlive the collider
+        std::span<const math::Vec3<float>>  hull_points{};
+
+        static Collider sphere(float radius, const math::Vec3<float>& center = { 0.0f, 0.0f, 0.0f });
+        static Collider capsule(float radius, float half_height, const math::Vec3<float>& axis = { 0.0f, 1.0f, 0.0f }, const math::Vec3<float>& center = { 0.0f, 0.0f, 0.0f });
+        static Collider box(const math::Vec3<float>& half_extents, const math::Vec3<float>& center = { 0.0f, 0.0f, 0.0f });
+        static Collider box(const AABB& bounds);
+        static Collider convex_hull(std::span<const math::Vec3<float>> points, const math::Vec3<float>& center = { 0.0f, 0.0f, 0.0f });
+
+        // bounds relative to the body position
+        AABB local_bounds() const;
+        // farthest point along direction relative to the body position
+        math::Vec3<float> support(const math::Vec3<float>& direction) const;
+    };
+
+    // dispatches to a test specialized for the pair of shapes,
+    // hulls and capsule against box go through gjk and epa, the rest have closed form tests,
+    // fills the manifold like collide_aabb (normal from a to b, negative depth is a gap closer than margin)
+    bool collide(
+        const Collider&             a,
+        const math::Vec3<float>&    position_a,
+        const Collider&             b,
+        const math::Vec3<float>&    position_b,
+        ContactManifold&            manifold,
+        float                       margin = 0.0f
+    );
+}
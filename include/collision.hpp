@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include "meshes.hpp"
+#include "physicsTypes.hpp"
+#include "vec.hpp"
+
+namespace my_gl {
+    struct AABB {
+        // empty by default, never overlaps anything
+        math::Vec3<float> min = math::Vec3<float>(std::numeric_limits<float>::max());
+        math::Vec3<float> max = math::Vec3<float>(std::numeric_limits<float>::lowest());
+
+        static AABB from_boundaries(const meshes::Boundaries& boundaries);
+
+        void expand(const math::Vec3<float>& point);
+        bool overlaps(const AABB& rhs) const;
+        math::Vec3<float> center() const { return (min + max) * 0.5f; }
+    };
+
+    // order independent id of two bodies, smaller id goes to the high bits
+    inline uint64_t pair_key(BodyId a, BodyId b) {
+        return a < b
+            ? (static_cast<uint64_t>(a) << 32) | b
+            : (static_cast<uint64_t>(b) << 32) | a;
+    }
+
+    struct BodyPair {
+        BodyId      body_a;
+        BodyId      body_b;
+
+        uint64_t key() const { return pair_key(body_a, body_b); }
+    };
+
+    // bodies don't rotate, so all points of a contact face produce the same impulse
+    // and a single representative point per pair is enough
+    struct ContactManifold {
+        uint64_t            key;
+        BodyId              body_a;
+        BodyId              body_b;
+        // points from a to b
+        math::Vec3<float>   normal;
+        math::Vec3<float>   point;
+        // penetration, negative for speculative contacts
+        float               depth;
+        // accumulated impulses, persisted between steps for warm starting
+        float               normal_impulse{ 0.0f };
+        float               tangent_impulse[2]{ 0.0f, 0.0f };
+    };
+
+    // fills normal, point and depth of the manifold if boxes overlap or are closer than margin,
+    // negative depth is a gap which is still allowed to close during the step
+    bool collide_aabb(const AABB& a, const AABB& b, ContactManifold& manifold, float margin = 0.0f);
+
+    // time of impact of b moving by motion relative to a, slab test against the swept box,
+    // fills a speculative manifold (depth is minus the gap) if they start touching within the motion
+    bool sweep_aabb(const AABB& a, const AABB& b, const math::Vec3<float>& motion, ContactManifold& manifold);
+}
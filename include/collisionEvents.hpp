@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "physicsTypes.hpp"
+#include "vec.hpp"
+
+namespace my_gl {
+    struct CollisionEvent {
+        enum class Type : uint8_t {
+            BEGIN,
+            PERSIST,
+            END,
+        };
+
+        Type                type;
+        BodyId              body_a;
+        BodyId              body_b;
+        // points from a to b, for END the last known values
+        math::Vec3<float>   normal;
+        float               depth;
+    };
+
+    // fixed size ring of events, only allocates on construction and reserve,
+    // when consumer falls behind the oldest events are overwritten
+    class CollisionEventQueue {
+    public:
+        // capacity is rounded up to a power of two
+        explicit CollisionEventQueue(std::size_t capacity = 1024);
+
+        void push(const CollisionEvent& event);
+        // oldest first, false when empty
+        bool pop(CollisionEvent& event);
+        void clear();
+        // grows to at least capacity, rounded up to a power of two, queued events are kept
+        void reserve(std::size_t capacity);
+
+        std::size_t size() const { return _size; }
+        std::size_t capacity() const { return _events.size(); }
+        // events lost since construction because nobody consumed them in time
+        uint64_t    overwritten() const { return _overwritten; }
+
+    private:
+        std::vector<CollisionEvent>     _events;
+        std::size_t                     _head{ 0 };
+        std::size_t                     _size{ 0 };
+        uint64_t                        _overwritten{ 0 };
+    };
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace my_gl {
+    class Program;
+    class VertexArray;
+    struct Texture;
+
+    // plain data gl commands, recorded on any thread, replayed on the gl thread
+    namespace commands {
+        // this enum is also the header of every recorded command
+        enum Type : uint32_t {
+            USE_PROGRAM,
+            BIND_VERTEX_ARRAY,
+            BIND_TEXTURE,
+            SET_TRANSPARENT,
+            BIND_OBJECT_DATA,
+            ATTACH_INSTANCES,
+            DRAW_ELEMENTS,
+            MULTI_DRAW_ELEMENTS_INDIRECT,
+        };
+
+        struct UseProgram {
+            static constexpr Type TYPE{ USE_PROGRAM };
+            const Program*      program;
+        };
+
+        // dynamic vaos stream their vertices when bound
+        struct BindVertexArray {
+            static constexpr Type TYPE{ BIND_VERTEX_ARRAY };
+            const VertexArray*  vao;
+        };
+
+        struct BindTexture {
+            static constexpr Type TYPE{ BIND_TEXTURE };
+            const Texture*      texture;
+        };
+
+        // blending on and depth writes off, or back
+        struct SetTransparent {
+            static constexpr Type TYPE{ SET_TRANSPARENT };
+            bool                is_transparent;
+        };
+
+        struct BindObjectData {
+            static constexpr Type TYPE{ BIND_OBJECT_DATA };
+            uint32_t            buffer_id;
+            std::size_t         byte_offset;
+        };
+
+        struct AttachInstances {
+            static constexpr Type TYPE{ ATTACH_INSTANCES };
+            const VertexArray*  vao;
+            uint32_t            buffer_id;
+            std::size_t         byte_offset;
+        };
+
+        // instance_count 0 is a plain draw
+        struct DrawElements {
+            static constexpr Type TYPE{ DRAW_ELEMENTS };
+            GLenum              mode;
+            uint32_t            count;
+            std::size_t         index_byte_offset;
+            uint32_t            instance_count;
+        };
+
+        struct MultiDrawElementsIndirect {
+            static constexpr Type TYPE{ MULTI_DRAW_ELEMENTS_INDIRECT };
+            GLenum              mode;
+            uint32_t            buffer_id;
+            std::size_t         commands_byte_offset;
+            uint32_t            draw_count;
+        };
+    }
+
+    // commands packed one after another in an arena that keeps its storage between frames
+    class CommandList {
+    public:
+        template<typename T>
+        void record(const T& command) {
+            static_assert(std::is_trivially_copyable_v<T>, "commands must be plain data");
+            const std::size_t offset{ _arena.size() };
+            _arena.resize(offset + HEADER_BYTE_SIZE + padded_size(sizeof(T)));
+            const Header header{ .type = T::TYPE, .byte_size = static_cast<uint32_t>(padded_size(sizeof(T))) };
+            std::memcpy(_arena.data() + offset, &header, sizeof(Header));
+            std::memcpy(_arena.data() + offset + HEADER_BYTE_SIZE, &command, sizeof(T));
+            if constexpr (T::TYPE == commands::DRAW_ELEMENTS || T::TYPE == commands::MULTI_DRAW_ELEMENTS_INDIRECT) {
+                ++_draw_calls;
+            }
+        }
+
+        void        clear() { _arena.clear(); _draw_calls = 0; }
+        // gl thread only
+        void        replay() const;
+        uint32_t    draw_calls() const { return _draw_calls; }
+        bool        empty() const { return _arena.empty(); }
+
+    private:
+        struct Header {
+            commands::Type  type;
+            uint32_t        byte_size;
+        };
+        static constexpr std::size_t HEADER_BYTE_SIZE{ 8 };
+        static_assert(sizeof(Header) == HEADER_BYTE_SIZE);
+
+        static constexpr std::size_t padded_size(std::size_t byte_size) { return (byte_size + 7) & ~std::size_t{ 7 }; }
+
+        std::vector<std::byte>  _arena;
+        uint32_t                _draw_calls{ 0 };
+    };
+}
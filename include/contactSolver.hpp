@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "collision.hpp"
+#include "physicsTypes.hpp"
+
+namespace my_gl {
+    struct SolverSettings {
+        uint32_t    iterations{ 8 };
+        // fraction of penetration removed per step
+        float       baumgarte{ 0.2f };
+        // penetration allowed without correction, keeps resting contacts alive
+        float       penetration_slop{ 0.005f };
+        // slower impacts don't bounce
+        float       restitution_threshold{ 0.5f };
+    };
+
+    // sequential impulses with friction and restitution,
+    // accumulated impulses of the previous step are used as a starting guess
+    class ContactSolver {
+    public:
+        // manifolds must be sorted by key
+        void solve(
+            std::span<ContactManifold>  manifolds,
+            SoAVec3&                    velocity,
+            const std::vector<float>&   inv_mass,
+            const std::vector<float>&   friction,
+            const std::vector<float>&   restitution,
+            float                       step_duration
+        );
+
+        SolverSettings      _settings;
+
+    private:
+        struct CachedImpulse {
+            uint64_t            key;
+            math::Vec3<float>   normal;
+            float               normal_impulse;
+            float               tangent_impulse[2];
+        };
+
+        struct ConstraintData {
+            math::Vec3<float>   tangent[2];
+            float               mass;
+            float               bias;
+            float               friction;
+        };
+
+        void warm_start(std::span<ContactManifold> manifolds);
+        void store_impulses(std::span<const ContactManifold> manifolds);
+
+        // sorted by key, filled at the end of every solve
+        std::vector<CachedImpulse>      _cache;
+        std::vector<ConstraintData>     _constraints;
+    };
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "matrix.hpp"
+#include "vec.hpp"
+
+namespace my_gl {
+    struct BoundingSphere {
+        math::Vec3<float>   center;
+        // negative for objects without bounds, they are never culled
+        float               radius;
+    };
+
+    // soa, so spheres are tested 4 at a time
+    struct BoundingSpheres {
+        std::vector<float>  x;
+        std::vector<float>  y;
+        std::vector<float>  z;
+        std::vector<float>  radius;
+
+        void        resize(std::size_t count);
+        // distinct indices may be set from different threads
+        void        set(std::size_t index, const BoundingSphere& sphere);
+        std::size_t size() const { return x.size(); }
+    };
+
+    // clip volume in world space, plane normals point inside
+    struct Frustum {
+        // xyz is the normal, w the distance, normalized so distances are in world units
+        std::array<std::array<float, 4>, 6>   planes;
+
+        static Frustum from_view_proj(const math::Matrix44<float>& view_proj_mat);
+
+        // visible[i] is 0 for spheres entirely behind one of the planes, 1 otherwise,
+        // returns how many are visible
+        std::size_t cull(const BoundingSpheres& spheres, std::vector<uint8_t>& visible) const;
+    };
+}
@@ -5,11 +5,16 @@
 #include <array>
 #include <span>
 #include "animation.hpp"
+#include "commandList.hpp"
+#include "frustum.hpp"
 #include "math.hpp"
 #include "physics.hpp"
+#include "physicsWorld.hpp"
 #include "matrix.hpp"
+#include "renderQueue.hpp"
 #include "texture.hpp"
 #include "sharedTypes.hpp"
+#include "uniformBuffer.hpp"
 #include "vec.hpp"
 
 namespace my_gl {
@@ -81,7 +86,6 @@ namespace my_gl {
             GLenum                      draw_type,
             Material::Type              material_type,
             const Texture* const        texture,
-            my_gl::math::Vec3<float>&&  change_collision_vec,
             bool                        is_static
         );
 
@@ -89,18 +93,27 @@ namespace my_gl {
         GeometryObjectPrimitive(const GeometryObjectPrimitive& rhs) = default;
         ~GeometryObjectPrimitive() = default;
 
-        void                        calc_model_mat_frame(Duration_sec frame_time);
-        // void                        update_physics(float delta_time);
-        bool                        check_collision(GeometryObjectPrimitive& second);
-        void                        handle_collision(GeometryObjectPrimitive& second);
-        void                        bind_state() const;
-        void                        un_bind_state() const;
-        void                        draw() const;
+        void                        register_physics(PhysicsWorld& world);
+        // moves animation matrices to the current time, transform data can be shared
+        // by copied primitives, so this runs serially, before the model matrices
+        void                        update_anims();
+        // only reads the animation matrices, safe to run for many primitives at once
+        math::Matrix44<float>       calc_model_mat(const math::Vec3<float>& physics_pos) const;
+        void                        calc_model_mat_frame(const PhysicsWorld& world, float physics_alpha);
         void                        update_anims_time(Duration_sec frame_time);
-        void                        render(const math::Matrix44<float>& view_mat, const math::Matrix44<float>& view_proj_mat, Duration_sec frame_time, float time_0to1);
+        // all of these use the model matrix of the last calc_model_mat_frame
+        BoundingSphere              world_bounds() const;
+        // the draw happens when the queue is executed
+        void                        emit(RenderQueue& queue, const math::Matrix44<float>& view_mat) const;
+        ObjectDataStd140            object_data(const math::Matrix44<float>& view_mat, const math::Matrix44<float>& view_proj_mat) const;
+        InstanceData                instance_data() const;
+        // instance_count 0 for non instanced vaos, they read the ObjectData block,
+        // instanced ones read matrices from the instances and the frame data block
+        commands::DrawElements      draw_command(uint32_t instance_count) const;
+        // fnv-1a of the model matrix of the last rendered frame, chained onto hash
+        uint64_t                    hash_transforms(uint64_t hash) const;
 
         std::span<TransformData>    _transform_data;
-        my_gl::math::Vec3<float>    _change_collision_vec;
         Physics<float>* const       _physics;
         const Texture* const        _texture;
         const Program&              _program;
@@ -108,9 +121,13 @@ namespace my_gl {
         std::size_t                 _vertices_count;
         std::size_t                 _buffer_byte_offset;
         math::Matrix44<float>       _model_mat{ my_gl::math::Matrix44<float>::identity_new() };
+        // around the mesh before any transform
+        BoundingSphere              _local_bounds;
         GLenum                      _draw_type;
         Material::Type              _material_type;
         bool                        _is_static;
+        // drawn after opaque ones, back to front, with blending and no depth writes
+        bool                        _is_transparent{ false };
     };
 
     class GeometryObjectComplex {
@@ -118,8 +135,10 @@ namespace my_gl {
         GeometryObjectComplex(std::vector<GeometryObjectPrimitive>&& primitives);
         GeometryObjectComplex(const std::vector<GeometryObjectPrimitive>& primitives);
 
-        void render(const math::Matrix44<float>& view_mat, const math::Matrix44<float>& view_proj_mat, Duration_sec frame_time, float time_0to1);
+        void register_physics(PhysicsWorld& world);
         void update_anims_time(Duration_sec frame_time);
+        uint64_t hash_transforms(uint64_t hash) const;
+        std::span<GeometryObjectPrimitive> primitives() { return _primitives; }
     private:
         std::vector<GeometryObjectPrimitive> _primitives;
     };
@@ -0,0 +1,66 @@
+#pragma once
+#include <GL/glew.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace my_gl {
+    struct GLStateStats {
+        // calls that reached gl
+        uint64_t    issued{ 0 };
+        // calls skipped because gl already was in that state
+        uint64_t    elided{ 0 };
+    };
+
+    // shadow copy of the bindings and enable flags set through it,
+    // calls that wouldn't change anything never reach the driver,
+    // gl calls made around it must be followed by invalidate()
+    class GLStateCache {
+    public:
+        static constexpr uint32_t MAX_TEXTURE_UNITS{ 32 };
+
+        GLStateCache() { invalidate(); }
+
+        void    use_program(uint32_t program_id);
+        // element array buffer is part of the vao, so it is forgotten on a vao change
+        void    bind_vertex_array(uint32_t vao_id);
+        // untracked targets are always issued
+        void    bind_buffer(GLenum target, uint32_t buffer_id);
+        // indexed bindings aren't tracked, the call is always issued
+        void    bind_buffer_base(GLenum target, uint32_t index, uint32_t buffer_id);
+        void    bind_buffer_range(GLenum target, uint32_t index, uint32_t buffer_id, std::size_t byte_offset, std::size_t byte_size);
+        // unit starts at 0, not at GL_TEXTURE0
+        void    bind_texture(uint32_t unit, GLenum target, uint32_t texture_id);
+        void    set_enabled(GLenum cap, bool enabled);
+        // everything is unknown again, the next call of each kind is issued
+        void    invalidate();
+
+        GLStateStats    _stats;
+
+    private:
+        static constexpr uint32_t UNKNOWN{ std::numeric_limits<uint32_t>::max() };
+        static constexpr std::array<GLenum, 5> BUFFER_TARGETS{
+            GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_SHADER_STORAGE_BUFFER
+        };
+        static constexpr std::array<GLenum, 3> TEXTURE_TARGETS{ GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_CUBE_MAP };
+        static constexpr std::array<GLenum, 6> CAPS{
+            GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_SCISSOR_TEST, GL_STENCIL_TEST, GL_PROGRAM_POINT_SIZE
+        };
+
+        // true when the call can be skipped, counts it either way
+        bool    is_redundant(uint32_t& shadow, uint32_t value);
+
+        uint32_t                                                                    _program;
+        uint32_t                                                                    _vao;
+        uint32_t                                                                    _active_unit;
+        std::array<uint32_t, BUFFER_TARGETS.size()>                                 _buffers;
+        std::array<std::array<uint32_t, TEXTURE_TARGETS.size()>, MAX_TEXTURE_UNITS> _textures;
+        std::array<uint32_t, CAPS.size()>                                           _caps;
+    };
+
+    namespace globals {
+        // there is a single gl context, so a single cache
+        extern GLStateCache gl_state;
+    }
+}
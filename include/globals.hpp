@@ -1,5 +1,6 @@
 #pragma once
 
+#include "replay.hpp"
 #include "vec.hpp"
 
 namespace my_gl  {
@@ -23,5 +24,7 @@ namespace my_gl  {
         extern math::Vec4<float>            light_pos;
         extern Camera   camera;
         extern Light    light;
+        // records input of the session or feeds a recorded one back
+        extern ReplayLog    replay;
     }
 }
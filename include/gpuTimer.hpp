@@ -0,0 +1,60 @@
+#pragma once
+#include <GL/glew.h>
+#include <array>
+#include <cstdint>
+
+namespace my_gl {
+    class Profiler;
+
+    // GL_TIMESTAMP queries around gpu scopes, each frame in flight has its own set.
+    // a set is read when it comes around again, FRAMES_IN_FLIGHT frames later,
+    // results not available by then are dropped instead of waited for
+    class GpuTimer {
+    public:
+        static constexpr uint32_t FRAMES_IN_FLIGHT{ 2 };
+        static constexpr uint32_t SCOPES_MAX{ 16 };
+        static constexpr uint32_t INVALID_SCOPE{ UINT32_MAX };
+
+        GpuTimer();
+        GpuTimer(const GpuTimer& rhs) = delete;
+        GpuTimer& operator=(const GpuTimer& rhs) = delete;
+        ~GpuTimer();
+
+        // hands the results of the set about to be reused to the profiler,
+        // scopes are recorded for the frame the profiler is in, if it's enabled
+        void        begin_frame(Profiler& profiler);
+        uint32_t    begin_scope(const char* name);
+        void        end_scope(uint32_t scope);
+
+    private:
+        struct QuerySet {
+            // start and end query of each scope
+            std::array<uint32_t, SCOPES_MAX * 2>    queries{};
+            std::array<const char*, SCOPES_MAX>     names{};
+            uint64_t                                frame_index{ 0 };
+            uint32_t                                scope_count{ 0 };
+        };
+
+        void        collect(QuerySet& set, Profiler& profiler);
+
+        std::array<QuerySet, FRAMES_IN_FLIGHT>  _sets;
+        uint32_t                                _set{ 0 };
+        bool                                    _is_recording{ false };
+    };
+
+    // gpu scope until the end of the block
+    class GpuScope {
+    public:
+        GpuScope(GpuTimer& timer, const char* name)
+            : _timer{ timer }
+            , _scope{ timer.begin_scope(name) }
+        {}
+        GpuScope(const GpuScope& rhs) = delete;
+        GpuScope& operator=(const GpuScope& rhs) = delete;
+        ~GpuScope() { _timer.end_scope(_scope); }
+
+    private:
+        GpuTimer&   _timer;
+        uint32_t    _scope;
+    };
+}
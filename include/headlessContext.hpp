@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace my_gl {
+    // gl context without any window, on egl's surfaceless platform (mesa, llvmpipe works without a gpu),
+    // everything is drawn to an fbo of the given size, bound in place of the default framebuffer
+    class HeadlessContext {
+    public:
+        // exits on failure, like init_window
+        HeadlessContext(uint32_t width, uint32_t height);
+        HeadlessContext(const HeadlessContext& rhs) = delete;
+        HeadlessContext& operator=(const HeadlessContext& rhs) = delete;
+        ~HeadlessContext();
+
+        // rgba8, bottom row first, waits for the draws
+        std::vector<uint8_t>    read_pixels() const;
+        // fnv-1a of read_pixels, equal between runs rendering the same frames on the same driver
+        uint64_t                checksum() const;
+
+        uint32_t                width() const { return _width; }
+        uint32_t                height() const { return _height; }
+
+    private:
+        // EGLDisplay and EGLContext, egl headers stay out of here
+        void*       _display{ nullptr };
+        void*       _context{ nullptr };
+        uint32_t    _fbo_id{ 0 };
+        uint32_t    _color_id{ 0 };
+        uint32_t    _depth_id{ 0 };
+        uint32_t    _width;
+        uint32_t    _height;
+    };
+}
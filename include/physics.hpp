@@ -1,13 +1,21 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include "colliders.hpp"
+#include "math.hpp"
+#include "physicsWorld.hpp"
+#include "sharedTypes.hpp"
 #include "vec.hpp"
-#include "matrix.hpp"
 
 namespace my_gl {
+// describes initial state of a body,
+// after registration the live state is owned by PhysicsWorld and addressed by _body
 template<std::floating_point T>
 struct Physics {
 public:
     Physics(float mass)
-        : _mat{}
-        , _curr_val{}
+        : _start_val{}
         , _velocity{}
         , _acceleration{}
         , _mass{ mass }
@@ -19,26 +27,56 @@ public:
         float           mass,
         math::Vec3<T>&& start_val = {0.0f, 0.0f, 0.0f}
     )
-        : _mat{ math::Matrix44<T>::translation(start_val)}
-        , _curr_val{ std::move(start_val) }
+        : _start_val{ std::move(start_val) }
         , _velocity{ std::move(velocity) }
         , _acceleration{ std::move(acceleration) }
         , _mass{ mass }
     {}
 
-    math::Matrix44<T>& update(float delta_time) {
-        _velocity += _acceleration * delta_time;
-        _curr_val += _velocity * delta_time;
-        _mat.translate(_curr_val);
-        return _mat;
-    }
-
-private:
-    math::Matrix44<T>               _mat;
-    my_gl::math::Vec3<T>            _curr_val;
-public:
+    my_gl::math::Vec3<T>            _start_val;
     my_gl::math::Vec3<T>            _velocity;
     my_gl::math::Vec3<T>            _acceleration;
     float                           _mass;
+    float                           _restitution{ 0.2f };
+    float                           _friction{ 0.5f };
+    // fast mover, gets continuous collision so it can't tunnel
+    bool                            _ccd{ false };
+    // collision shape, without one the bounds of the render mesh are used
+    std::optional<Collider>         _collider;
+    BodyId                          _body{ INVALID_BODY };
+};
+
+// accumulates variable frame time and splits it into fixed simulation steps
+struct FixedTimestep {
+    FixedTimestep(float step_rate_hz = 60.0f, uint32_t max_substeps = 8)
+        : _step_duration{ 1.0f / step_rate_hz }
+        , _max_substeps{ max_substeps }
+    {}
+
+    // returns count of fixed steps to simulate for this frame
+    uint32_t advance(Duration_sec frame_time) {
+        _accumulator += frame_time.count();
+
+        uint32_t steps{ static_cast<uint32_t>(_accumulator / _step_duration) };
+        if (steps > _max_substeps) {
+            // can't catch up, drop the time we are not able to simulate
+            steps = _max_substeps;
+            _accumulator = _step_duration * steps;
+        }
+        _accumulator -= _step_duration * steps;
+
+        return steps;
+    }
+
+    // how far rendering is between previous and current simulated state
+    float alpha() const { return std::clamp(_accumulator / _step_duration, 0.0f, 1.0f); }
+    float step_duration() const { return _step_duration; }
+
+    void set_step_rate(float step_rate_hz) { _step_duration = 1.0f / step_rate_hz; }
+    void set_max_substeps(uint32_t max_substeps) { _max_substeps = max_substeps; }
+
+    float       _step_duration;
+    float       _accumulator{ 0.0f };
+    uint32_t    _max_substeps;
 };
 }
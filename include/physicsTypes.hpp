@@ -0,0 +1,13 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace my_gl {
+    using BodyId = uint32_t;
+    constexpr BodyId INVALID_BODY{ std::numeric_limits<BodyId>::max() };
+
+    // x, y, z components of many vectors stored in separate arrays
+    using SoAVec3 = std::array<std::vector<float>, 3>;
+}
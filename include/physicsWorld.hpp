@@ -0,0 +1,159 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "broadphase.hpp"
+#include "colliders.hpp"
+#include "collision.hpp"
+#include "collisionEvents.hpp"
+#include "contactSolver.hpp"
+#include "physicsTypes.hpp"
+#include "sharedTypes.hpp"
+#include "threadPool.hpp"
+#include "vec.hpp"
+
+namespace my_gl {
+    struct SleepSettings {
+        // bodies slower than this start counting time to sleep
+        float       velocity_threshold{ 0.05f };
+        // island falls asleep when all of its bodies were slow for this long
+        float       time_to_sleep{ 0.5f };
+    };
+
+    // time spent in each phase of step, summed until reset
+    struct PhysicsTimings {
+        // velocities, positions and bounds
+        Duration_sec    integrate{};
+        Duration_sec    broadphase{};
+        Duration_sec    narrowphase{};
+        Duration_sec    solver{};
+        // collision events and sleeping
+        Duration_sec    events{};
+        uint64_t        steps{ 0 };
+    };
+
+    // owns simulation state of all bodies in SoA layout,
+    // so whole world can be integrated with a vectorized kernel
+    class PhysicsWorld {
+    public:
+        PhysicsWorld() = default;
+        explicit PhysicsWorld(std::size_t body_capacity);
+
+        // mass == 0 makes a static body
+        BodyId              add_body(
+            const math::Vec3<float>&    position,
+            const math::Vec3<float>&    velocity,
+            const math::Vec3<float>&    acceleration,
+            float                       mass,
+            float                       restitution = 0.2f,
+            float                       friction = 0.5f
+        );
+        void                reserve(std::size_t body_capacity);
+        // narrowphase runs on the pool if set, results don't depend on its size
+        void                set_thread_pool(ThreadPool* thread_pool) { _thread_pool = thread_pool; }
+        // integrate velocities, resolve contacts, integrate positions
+        void                step(float step_duration);
+
+        // bounds relative to body position, body collides as this box,
+        // bodies without bounds don't collide
+        void                set_local_bounds(BodyId body, const AABB& local_bounds);
+        // shape to collide with, bounds are taken from it
+        void                set_collider(BodyId body, const Collider& collider);
+        const Collider&     collider(BodyId body) const { return _colliders[body]; }
+        // continuous collision for fast movers, their motion during the step is swept
+        // against other bodies, so they can't pass through thin ones
+        void                set_ccd(BodyId body, bool enabled);
+        AABB                world_bounds(BodyId body) const;
+        math::Vec3<float>   position(BodyId body) const;
+        // lerp between previous and current step, see FixedTimestep::alpha()
+        math::Vec3<float>   interpolated_position(BodyId body, float alpha) const;
+        math::Vec3<float>   velocity(BodyId body) const;
+        math::Vec3<float>   acceleration(BodyId body) const;
+        float               inv_mass(BodyId body) const { return _inv_mass[body]; }
+        void                set_position(BodyId body, const math::Vec3<float>& position);
+        void                set_velocity(BodyId body, const math::Vec3<float>& velocity);
+        void                set_acceleration(BodyId body, const math::Vec3<float>& acceleration);
+        // wakes the whole island the body slept in
+        void                wake(BodyId body);
+        bool                is_awake(BodyId body) const { return _awake[body] != 0.0f; }
+        std::size_t         size() const { return _inv_mass.size(); }
+        // contacts resolved during the last step, sorted by pair key
+        std::span<const ContactManifold> contacts() const { return _manifolds; }
+        // bumped whenever a body is added, moved or gets new bounds,
+        // equal values mean nothing a query could see has changed in between
+        uint64_t            moves() const { return _moves; }
+
+        ContactSolver       _solver;
+        // begin/persist/end of touching contacts, filled once per step, consumed by game code
+        CollisionEventQueue _events;
+        // bodies closer than this get a speculative contact,
+        // keeps resting contacts (and their cached impulses) alive
+        float               _contact_margin{ 0.02f };
+        SleepSettings       _sleep_settings;
+        PhysicsTimings      _timings;
+
+    private:
+        const SoAVec3& curr_pos() const { return _pos[_curr_pos_index]; }
+        const SoAVec3& prev_pos() const { return _pos[_curr_pos_index ^ 1]; }
+
+        void integrate_velocities(float step_duration);
+        void integrate_positions(float step_duration);
+        void update_bounds();
+        void update_body_bounds(BodyId body);
+        void sweep_bounds(float step_duration);
+        void find_contacts(float step_duration);
+        bool collide_pair(const BodyPair& pair, float step_duration, ContactManifold& manifold) const;
+        bool wake_touched();
+        void update_sleep(float step_duration);
+        BodyId find_island(BodyId body);
+        void emit_events();
+
+        // positions are double buffered, integration writes the next state
+        // over the previous one and flips the index, so no copy is needed
+        std::array<SoAVec3, 2>          _pos;
+        SoAVec3                         _vel;
+        SoAVec3                         _acc;
+        std::vector<float>              _inv_mass;
+        std::vector<float>              _restitution;
+        std::vector<float>              _friction;
+        // 1 for awake dynamic bodies, 0 for sleeping and static ones,
+        // kept as float so it can mask the integration kernels
+        std::vector<float>              _awake;
+        std::vector<float>              _sleep_time;
+        // sleeping islands are rings linked through this, awake bodies point to themselves
+        std::vector<BodyId>             _island_next;
+        // union-find parents and island sleep times, rebuilt every step
+        std::vector<BodyId>             _island_parent;
+        std::vector<float>              _island_sleep_time;
+        SoAVec3                         _local_min;
+        SoAVec3                         _local_max;
+        // broadphase bounds, contain the whole step motion of ccd bodies
+        SoAVec3                         _bounds_min;
+        SoAVec3                         _bounds_max;
+        std::vector<Collider>           _colliders;
+        std::vector<uint8_t>            _ccd;
+        std::vector<BodyId>             _ccd_bodies;
+        uint32_t                        _curr_pos_index{ 0 };
+        uint64_t                        _moves{ 0 };
+
+        Broadphase                      _broadphase;
+        std::vector<BodyPair>           _pairs;
+        std::vector<ContactManifold>    _manifolds;
+        // touching contacts of the previous step sorted by key, diffed against the current ones
+        std::vector<ContactManifold>    _touching;
+        std::vector<ContactManifold>    _next_touching;
+
+        // contacts of a chunk of pairs, stored in the buffer of the worker which found them
+        struct ContactChunk {
+            uint32_t        worker;
+            std::size_t     begin;
+            std::size_t     count;
+        };
+
+        ThreadPool*                                 _thread_pool{ nullptr };
+        std::vector<std::vector<ContactManifold>>   _worker_manifolds;
+        std::vector<ContactChunk>                   _contact_chunks;
+    };
+}
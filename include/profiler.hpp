@@ -0,0 +1,97 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "sharedTypes.hpp"
+
+namespace my_gl {
+    enum class ProfileSource : uint8_t {
+        CPU,
+        GPU,
+    };
+
+    struct ProfileSample {
+        const char*     name;
+        ProfileSource   source;
+        // nesting of cpu scopes, gpu samples are flat
+        uint16_t        depth;
+        // from the start of the frame, gpu ones from the first gpu sample of the frame
+        Duration_sec    start;
+        Duration_sec    duration;
+    };
+
+    struct ProfileFrame {
+        uint64_t                    index{ 0 };
+        Duration_sec                duration{};
+        std::vector<ProfileSample>  samples;
+    };
+
+    // over the frames in the ring, samples of the same name in a frame are summed
+    struct ProfileStats {
+        uint32_t        frames{ 0 };
+        Duration_sec    average{};
+        Duration_sec    p50{};
+        Duration_sec    p95{};
+        Duration_sec    p99{};
+        Duration_sec    max{};
+    };
+
+    // nested cpu scopes and gpu samples of the last FRAMES_COUNT frames,
+    // scopes are only recorded on the thread running the frames, those of workers are skipped,
+    // names must outlive the profiler, string literals are expected
+    class Profiler {
+    public:
+        static constexpr std::size_t FRAMES_COUNT{ 256 };
+        static constexpr uint32_t INVALID_SCOPE{ UINT32_MAX };
+
+        void            begin_frame();
+        void            end_frame();
+        // returns the scope to end, INVALID_SCOPE if not recorded
+        uint32_t        begin_scope(const char* name);
+        void            end_scope(uint32_t scope);
+        // gpu results arrive frames later, they are dropped if their frame left the ring
+        void            add_gpu_sample(uint64_t frame_index, const char* name, Duration_sec start, Duration_sec duration);
+
+        // of the frame being recorded, between frames the one the next begin_frame gets
+        uint64_t        frame_index() const { return _frame_index; }
+        const ProfileFrame* frame(uint64_t frame_index) const;
+        // the empty name gives whole frames
+        ProfileStats    stats(std::string_view name, ProfileSource source = ProfileSource::CPU) const;
+        // a row per sample of the frames in the ring, oldest first
+        bool            write_csv(const char* path) const;
+
+        // nothing is recorded while false
+        bool            _enabled{ false };
+
+    private:
+        std::array<ProfileFrame, FRAMES_COUNT>  _frames;
+        // cpu scopes not ended yet
+        std::vector<uint32_t>                   _open_scopes;
+        // float seconds since boot would lose the precision of short scopes
+        std::chrono::steady_clock::time_point   _frame_start;
+        std::thread::id                         _frame_thread;
+        uint64_t                                _frame_index{ 0 };
+        bool                                    _is_in_frame{ false };
+    };
+
+    // cpu scope of the global profiler until the end of the block
+    class ProfileScope {
+    public:
+        explicit ProfileScope(const char* name);
+        ProfileScope(const ProfileScope& rhs) = delete;
+        ProfileScope& operator=(const ProfileScope& rhs) = delete;
+        ~ProfileScope();
+
+    private:
+        uint32_t    _scope;
+    };
+
+    namespace globals {
+        // defined with the profiler, headless builds have it without the rest of the globals
+        extern Profiler profiler;
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "commandList.hpp"
+#include "matrix.hpp"
+#include "streamBuffer.hpp"
+
+namespace my_gl {
+    class GeometryObjectPrimitive;
+    class ThreadPool;
+
+    struct DrawPacket {
+        uint64_t                        key;
+        const GeometryObjectPrimitive*  primitive;
+    };
+
+    // per instance attributes of instanced programs, they are declared with these offsets and divisor 1
+    struct InstanceData {
+        // column major, as gl reads it
+        std::array<float, 16>   model_mat;
+        uint32_t                material;
+    };
+
+    // layout glMultiDrawElementsIndirect reads
+    struct DrawElementsIndirectCommand {
+        uint32_t    count;
+        uint32_t    instance_count;
+        uint32_t    first_index;
+        int32_t     base_vertex;
+        uint32_t    base_instance;
+    };
+
+    // consecutive packets sharing a draw, more than one only for instanced vaos
+    struct DrawBatch {
+        uint32_t    first_packet;
+        uint32_t    packet_count;
+        // from the first instance of its bucket
+        uint32_t    first_instance;
+        // in the stream buffer, instances of an instanced batch, ObjectData block of the others
+        std::size_t data_byte_offset;
+    };
+
+    // consecutive batches sharing state, instanced ones become a single multi draw,
+    // the others are always a bucket of one
+    struct DrawBucket {
+        uint32_t    first_packet;
+        uint32_t    first_batch;
+        uint32_t    batch_count;
+        uint32_t    instance_count;
+        std::size_t data_byte_offset;
+        std::size_t commands_byte_offset;
+        // mapped memory at the offsets above, valid while the frame is written
+        std::byte*  data;
+        std::byte*  commands;
+    };
+
+    // draws of a frame, sorted so that primitives sharing state are drawn together,
+    // opaque ones go first, front to back for early depth rejection,
+    // transparent ones after them, back to front so they blend correctly
+    class RenderQueue {
+    public:
+        // key layout from the highest bit:
+        // opaque:      0 | program 8 | vao 10 | texture 10 | material 5 | depth 24 | 6 unused
+        // transparent: 1 | inverted depth 24 | program 8 | vao 10 | texture 10 | material 5 | 6 unused
+        // ids wider than their field only make sorting less effective, never wrong
+        static uint64_t make_key(uint32_t program_id, uint32_t vao_id, uint32_t texture_id, uint32_t material, float view_depth, bool is_transparent);
+
+        void    clear() { _packets.clear(); }
+        // view_depth is the distance in front of the camera
+        void    push(const GeometryObjectPrimitive& primitive, float view_depth);
+        // lsd radix sort by key, stable, passes over bytes equal in all keys are skipped
+        void    sort();
+        // binds state only where it differs from the previous batch,
+        // packets of an instanced vao sharing state and draw range become one instanced draw,
+        // per draw data is written to the stream buffer and referenced by offset.
+        // slices of the packets are written and recorded to command lists on the pool,
+        // the calling thread, which owns the context, only replays them
+        void    execute(const math::Matrix44<float>& view_mat, const math::Matrix44<float>& view_proj_mat, ThreadPool* thread_pool = nullptr);
+
+        std::span<const DrawPacket> packets() const { return _packets; }
+        std::span<const DrawBatch>  batches() const { return _batches; }
+        std::span<const DrawBucket> buckets() const { return _buckets; }
+        // gl draw calls of the last execute
+        uint32_t                    draw_calls() const { return _draw_calls; }
+
+        // false draws every batch on its own even where multi draw indirect is supported
+        bool                        _multi_draw_enabled{ true };
+
+    private:
+        void    build_batches();
+        // gl thread, places the data of every bucket in the stream buffer
+        void    allocate_draw_data();
+        // any thread, writes data of the packets in [begin, end) and records the buckets starting there
+        void    record(std::size_t begin, std::size_t end, CommandList& list, const math::Matrix44<float>& view_mat, const math::Matrix44<float>& view_proj_mat);
+        void    record_bucket(uint32_t bucket_index, CommandList& list);
+
+        std::vector<DrawPacket>     _packets;
+        std::vector<DrawPacket>     _scratch;
+        std::vector<DrawBatch>      _batches;
+        std::vector<DrawBucket>     _buckets;
+        // bucket of every packet
+        std::vector<uint32_t>       _packet_buckets;
+        // one per slice of packets, replayed in order
+        std::vector<CommandList>    _command_lists;
+        // created on the first execute, it needs a context
+        std::optional<StreamBuffer> _stream;
+        std::size_t                 _uniform_byte_alignment{ 0 };
+        uint32_t                    _draw_calls{ 0 };
+        bool                        _is_multi_draw{ false };
+    };
+}
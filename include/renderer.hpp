@@ -5,10 +5,17 @@
 #include <GL/glew.h>
 #include <cstdint>
 #include <string_view>
+#include "frustum.hpp"
 #include "geometryObject.hpp"
+#include "gpuTimer.hpp"
+#include "globals.hpp"
+#include "glState.hpp"
 #include "matrix.hpp"
 #include "sharedTypes.hpp"
 #include "meshes.hpp"
+#include "renderQueue.hpp"
+#include "simulation.hpp"
+#include "uniformBuffer.hpp"
 
 namespace my_gl {
     class VertexArray;
@@ -22,6 +29,9 @@ namespace my_gl {
         uint16_t        count;
         uint16_t        byte_stride;
         uint16_t        byte_offset;
+        // 1 for attributes read per instance from the instance buffer,
+        // more than 4 floats take consecutive locations, 4 per location
+        uint16_t        divisor{ 0 };
     };
 
     struct Uniform {
@@ -31,30 +41,46 @@ namespace my_gl {
 
     class VertexArray {
     public:
+        // binding index of the per instance attributes, far from the locations used by vertex attributes
+        static constexpr uint32_t INSTANCE_BINDING{ 15 };
+
+        // usage is GL_DYNAMIC_DRAW for vertices streamed every frame
         VertexArray(
             meshes::Mesh&&  mesh,
-            const Program&  program
+            const Program&  program,
+            GLenum          usage = GL_STATIC_DRAW
         );
         VertexArray(
             const meshes::Mesh& mesh,
-            const Program&      program
+            const Program&      program,
+            GLenum              usage = GL_STATIC_DRAW
         );
         VertexArray(const VertexArray& rhs) = default;
         VertexArray(VertexArray&& rhs) = default;
         ~VertexArray();
 
-        void bind() const { glBindVertexArray(_vao_id); }
-        void un_bind() const { glBindVertexArray(0); }
+        void bind() const { globals::gl_state.bind_vertex_array(_vao_id); }
+        void un_bind() const { globals::gl_state.bind_vertex_array(0); }
+        // uploads the current content of the mesh vertices, size must not change
+        void stream_vertices() const;
+        bool is_dynamic() const { return _usage != GL_STATIC_DRAW; }
+        // instances are read from byte_offset on, stride is the one of the instance attributes
+        void attach_instances(uint32_t buffer_id, std::size_t byte_offset) const;
 
     private:
         void init(const std::vector<const Program*>& programs);
         void init(const Program& program);
+        void init_instance_attrib(const Attribute& attr);
 
     public:
         meshes::Mesh                    _mesh;
         uint32_t                        _vao_id;
         uint32_t                        _vbo_id;
         uint32_t                        _ibo_id;
+        GLenum                          _usage;
+        uint16_t                        _instance_stride{ 0 };
+        // program has per instance attributes, draws go through instancing
+        bool                            _is_instanced{ false };
     };
 
     class Program {
@@ -78,6 +104,8 @@ namespace my_gl {
         const Attribute* const get_attrib(std::string_view attrib_name) const;
         const Uniform* const get_uniform(std::string_view unif_name) const;
         void  set_attrib(Attribute& attr);
+        // binds the shared blocks the program declares to their binding points
+        void  bind_uniform_blocks() const;
         void  set_uniform_location(Uniform& unif);
         void  set_uniform_value(std::string_view unif_name, int32_t val) const;
         void  set_uniform_value(std::string_view unif_name, float val) const;
@@ -87,8 +115,8 @@ namespace my_gl {
         void  set_uniform_value(std::string_view unif_name, const my_gl::math::Vec4<float>& vec4_val) const;
         const std::unordered_map<std::string_view, Attribute>& get_attrs() const;
         const std::unordered_map<std::string_view, Uniform>& get_unifs() const;
-        void  use() const { glUseProgram(_program_id); }
-        void  un_use() const { glUseProgram(0); }
+        void  use() const { globals::gl_state.use_program(_program_id); }
+        void  un_use() const { globals::gl_state.use_program(0); }
         uint32_t get_id() const { return _program_id; }
 
     private:
@@ -97,24 +125,80 @@ namespace my_gl {
         uint32_t                                                _program_id{ 0 };
     };
 
+    struct FrameStats {
+        uint32_t    primitives{ 0 };
+        // outside the frustum, never reached the queue
+        uint32_t    culled{ 0 };
+        uint32_t    draw_calls{ 0 };
+    };
+
+    // time spent in each phase of render, summed until reset
+    struct RenderTimings {
+        Duration_sec    simulate{};
+        // model matrices and world bounds
+        Duration_sec    transforms{};
+        Duration_sec    cull{};
+        // emitting and sorting the queue
+        Duration_sec    build_draw_list{};
+        // writing, recording and replaying the queue, gpu time isn't included
+        Duration_sec    submit{};
+        uint64_t        frames{ 0 };
+    };
+
     class Renderer {
     public:
         Renderer(
             std::span<my_gl::GeometryObjectComplex>     complex_objs,
             std::span<my_gl::GeometryObjectPrimitive>   primitives,
             math::Matrix44<float>&&                     view_mat,
-            math::Matrix44<float>&&                     proj_mat
+            math::Matrix44<float>&&                     proj_mat,
+            FixedTimestep                               physics_timestep = {}
         );
 
-        void render(Duration_sec frame_time, float time_0to1);
+        // simulate, transforms, cull, build draw list, submit, each phase only
+        // reads what the previous ones left in the frame scratch
+        void render(Duration_sec frame_time);
+        void reset_timings() { _timings = RenderTimings{}; }
         void update_time(Duration_sec frame_time);
         Duration_sec get_curr_rendering_duration() const;
+        // fnv-1a of model matrices and cloth vertices of the last rendered frame,
+        // equal between runs fed with the same frame durations and input
+        uint64_t transforms_checksum() const;
 
         std::span<my_gl::GeometryObjectComplex>     _complex_objs;
         std::span<my_gl::GeometryObjectPrimitive>   _primitives;
         math::Matrix44<float>                       _view_mat;
         math::Matrix44<float>                       _proj_mat;
+        // world coords, written with the matrices to the frame data block
+        math::Vec3<float>                           _view_pos{ 0.0f, 0.0f, 0.0f };
+        Light                                       _light{};
+        // physics, cloths and scene queries, no gl in there
+        Simulation                                  _simulation;
+        // refilled every frame, kept to reuse its storage
+        RenderQueue                                 _render_queue;
+        UniformBuffer                               _frame_data;
+        // written once, materials don't change
+        UniformBuffer                               _material_table;
+        // of the last rendered frame
+        FrameStats                                  _frame_stats;
+        RenderTimings                               _timings;
+        // results go to the global profiler, while it's enabled
+        GpuTimer                                    _gpu_timer;
         Timepoint_sec                               _rendering_time_curr;
         Timepoint_sec                               _rendering_time_start;
+
+    private:
+        // fills the frame primitives, their model matrices and world bounds
+        void        compute_transforms(const PhysicsWorld& physics_world, float physics_alpha);
+        // fills visible from the bounds, returns how many are visible
+        std::size_t cull(const math::Matrix44<float>& view_proj_mat);
+        // queue of the visible primitives, sorted
+        void        build_draw_list();
+        void        submit(const math::Matrix44<float>& view_proj_mat);
+
+        // frame scratch, kept to reuse its storage
+        std::vector<GeometryObjectPrimitive*>       _frame_primitives;
+        BoundingSpheres                             _frame_bounds;
+        std::vector<uint8_t>                        _frame_visible;
     };
 }
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "sharedTypes.hpp"
+
+namespace my_gl {
+    // window input, as received by glfw callbacks
+    struct InputEvent {
+        enum class Type : uint8_t {
+            KEY,
+            MOUSE_MOVE,
+            SCROLL,
+        };
+
+        Type        type;
+        // key events only
+        int32_t     key{ 0 };
+        int32_t     action{ 0 };
+        // cursor position or scroll offset
+        float       x{ 0.0f };
+        float       y{ 0.0f };
+    };
+
+    // fnv-1a, chain calls by passing the previous result as hash
+    constexpr uint64_t FNV_OFFSET_BASIS{ 14695981039346656037ull };
+    uint64_t fnv1a(const void* data, std::size_t byte_size, uint64_t hash = FNV_OFFSET_BASIS);
+
+    // per frame durations and input of a session, so it can be played again
+    // with the same workload, checksums of transforms tell if the result is the same
+    class ReplayLog {
+    public:
+        enum class Mode : uint8_t {
+            OFF,
+            RECORD,
+            REPLAY,
+        };
+
+        struct Frame {
+            float       duration;
+            uint32_t    first_event;
+            uint32_t    event_count;
+            uint64_t    checksum;
+        };
+
+        // input received during the current frame
+        void                        record_event(const InputEvent& event);
+        // closes the current frame
+        void                        record_frame(Duration_sec frame_duration, uint64_t checksum);
+        void                        clear();
+
+        // binary file, false with a message on std::cerr when it fails
+        bool                        save(const char* path) const;
+        bool                        load(const char* path);
+
+        std::size_t                 size() const { return _frames.size(); }
+        const Frame&                frame(std::size_t index) const { return _frames[index]; }
+        std::span<const InputEvent> events(std::size_t index) const;
+
+        Mode                        _mode{ Mode::OFF };
+
+    private:
+        std::vector<Frame>          _frames;
+        std::vector<InputEvent>     _events;
+    };
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+#include "collision.hpp"
+#include "physicsTypes.hpp"
+#include "vec.hpp"
+
+namespace my_gl {
+    class PhysicsWorld;
+    class ThreadPool;
+
+    struct Ray {
+        math::Vec3<float>   origin;
+        // must be normalized
+        math::Vec3<float>   direction;
+        float               max_distance{ std::numeric_limits<float>::max() };
+    };
+
+    struct RayHit {
+        // INVALID_BODY if nothing was hit
+        BodyId              body{ INVALID_BODY };
+        float               distance{ 0.0f };
+        math::Vec3<float>   point;
+        math::Vec3<float>   normal;
+    };
+
+    // bounding volume hierarchy over world bounds of physics bodies,
+    // build it after stepping the world, queries only read it
+    // so they can run from many threads at once
+    class SceneQuery {
+    public:
+        void build(const PhysicsWorld& world);
+
+        // closest hit along the ray
+        bool raycast(const Ray& ray, RayHit& hit) const;
+        // hits[i] is the result of rays[i], spread over the pool if given
+        void raycast_batch(std::span<const Ray> rays, std::span<RayHit> hits, ThreadPool* thread_pool = nullptr) const;
+        // bodies with bounds touching the shape, appended to out
+        void overlap_sphere(const math::Vec3<float>& center, float radius, std::vector<BodyId>& out) const;
+        void overlap_box(const AABB& box, std::vector<BodyId>& out) const;
+        // up to count bodies closest to the point (by distance to their bounds),
+        // out is replaced by them in order from the closest
+        void nearest(const math::Vec3<float>& point, uint32_t count, std::vector<BodyId>& out) const;
+
+    private:
+        struct Node {
+            AABB        bounds;
+            // first child for inner nodes (second one follows it), first item for leaves
+            uint32_t    first;
+            // 0 for inner nodes
+            uint32_t    item_count;
+        };
+
+        struct Item {
+            AABB        bounds;
+            BodyId      body;
+        };
+
+        void build_node(uint32_t node_index, uint32_t first, uint32_t item_count);
+
+        std::vector<Node>       _nodes;
+        // leaves reference ranges of these
+        std::vector<Item>       _items;
+    };
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace my_gl {
+    namespace simd {
+        // 4-wide float lane, falls back to plain scalar code on targets without SSE
+        struct F32x4 {
+            static constexpr std::size_t width{ 4 };
+
+#if defined(__SSE2__)
+            __m128 v;
+
+            static F32x4 load(const float* ptr) { return F32x4{ _mm_loadu_ps(ptr) }; }
+            static F32x4 broadcast(float val) { return F32x4{ _mm_set1_ps(val) }; }
+            void store(float* ptr) const { _mm_storeu_ps(ptr, v); }
+
+            friend F32x4 operator+(F32x4 lhs, F32x4 rhs) { return F32x4{ _mm_add_ps(lhs.v, rhs.v) }; }
+            friend F32x4 operator-(F32x4 lhs, F32x4 rhs) { return F32x4{ _mm_sub_ps(lhs.v, rhs.v) }; }
+            friend F32x4 operator*(F32x4 lhs, F32x4 rhs) { return F32x4{ _mm_mul_ps(lhs.v, rhs.v) }; }
+            friend F32x4 operator/(F32x4 lhs, F32x4 rhs) { return F32x4{ _mm_div_ps(lhs.v, rhs.v) }; }
+            static F32x4 sqrt(F32x4 val) { return F32x4{ _mm_sqrt_ps(val.v) }; }
+            static F32x4 min(F32x4 lhs, F32x4 rhs) { return F32x4{ _mm_min_ps(lhs.v, rhs.v) }; }
+            static F32x4 max(F32x4 lhs, F32x4 rhs) { return F32x4{ _mm_max_ps(lhs.v, rhs.v) }; }
+            // true if any lane is non zero
+            bool any() const { return _mm_movemask_ps(_mm_cmpneq_ps(v, _mm_setzero_ps())) != 0; }
+#else
+            float v[4];
+
+            static F32x4 load(const float* ptr) { return F32x4{ { ptr[0], ptr[1], ptr[2], ptr[3] } }; }
+            static F32x4 broadcast(float val) { return F32x4{ { val, val, val, val } }; }
+            void store(float* ptr) const { for (std::size_t i = 0; i < width; ++i) { ptr[i] = v[i]; } }
+
+            friend F32x4 operator+(F32x4 lhs, F32x4 rhs) { for (std::size_t i = 0; i < width; ++i) { lhs.v[i] += rhs.v[i]; } return lhs; }
+            friend F32x4 operator-(F32x4 lhs, F32x4 rhs) { for (std::size_t i = 0; i < width; ++i) { lhs.v[i] -= rhs.v[i]; } return lhs; }
+            friend F32x4 operator*(F32x4 lhs, F32x4 rhs) { for (std::size_t i = 0; i < width; ++i) { lhs.v[i] *= rhs.v[i]; } return lhs; }
+            friend F32x4 operator/(F32x4 lhs, F32x4 rhs) { for (std::size_t i = 0; i < width; ++i) { lhs.v[i] /= rhs.v[i]; } return lhs; }
+            static F32x4 sqrt(F32x4 val) { for (std::size_t i = 0; i < width; ++i) { val.v[i] = std::sqrt(val.v[i]); } return val; }
+            static F32x4 min(F32x4 lhs, F32x4 rhs) { for (std::size_t i = 0; i < width; ++i) { lhs.v[i] = rhs.v[i] < lhs.v[i] ? rhs.v[i] : lhs.v[i]; } return lhs; }
+            static F32x4 max(F32x4 lhs, F32x4 rhs) { for (std::size_t i = 0; i < width; ++i) { lhs.v[i] = rhs.v[i] > lhs.v[i] ? rhs.v[i] : lhs.v[i]; } return lhs; }
+            bool any() const { return v[0] != 0.0f || v[1] != 0.0f || v[2] != 0.0f || v[3] != 0.0f; }
+#endif
+        };
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "animation.hpp"
+#include "cloth.hpp"
+#include "physics.hpp"
+#include "physicsWorld.hpp"
+#include "sceneQuery.hpp"
+#include "sharedTypes.hpp"
+#include "threadPool.hpp"
+
+namespace my_gl {
+    // time spent in each phase of advance, summed until reset,
+    // physics phases are split further in PhysicsWorld::_timings
+    struct SimulationTimings {
+        Duration_sec    physics{};
+        Duration_sec    cloths{};
+        // builds done by scene_query(), not by advance
+        Duration_sec    scene_query{};
+        Duration_sec    animations{};
+        uint64_t        frames{ 0 };
+    };
+
+    // everything that moves, without any gl state,
+    // Renderer draws it, headless builds only step it
+    class Simulation {
+    public:
+        // thread_count includes the calling thread, 0 uses all hardware threads
+        explicit Simulation(FixedTimestep timestep = {}, uint32_t thread_count = 0);
+        Simulation(const Simulation& rhs) = delete;
+        Simulation& operator=(const Simulation& rhs) = delete;
+
+        // runs the fixed steps the frame time adds up to, then refreshes
+        // what is derived from them, returns count of steps
+        uint32_t            advance(Duration_sec frame_time);
+        // single fixed step of physics and cloths
+        void                step(float step_duration);
+        // how far the frame is between the previous and the current step
+        float               alpha() const { return _timestep.alpha(); }
+        void                reset_timings();
+        // raycasts, overlaps and nearest bodies, the tree is rebuilt here on the first
+        // query after a step which moved a body, so frames without queries don't pay for it,
+        // get it on the thread stepping the simulation before spreading queries over threads
+        const SceneQuery&   scene_query();
+
+        // declared before the world which uses it
+        ThreadPool                      _thread_pool;
+        PhysicsWorld                    _physics_world;
+        // forces a rebuild of the scene query on its next use
+        bool                            _scene_query_dirty{ true };
+        // stepped with the physics, their vertices are refreshed after the steps
+        std::span<Cloth>                _cloths;
+        // animations not owned by render objects, those update themselves when drawn
+        std::span<Animation<float>>     _animations;
+        FixedTimestep                   _timestep;
+        // of every step of the last advance, oldest first
+        std::vector<CollisionEvent>     _collision_events;
+        SimulationTimings               _timings;
+
+    private:
+        // moves what the last physics step queued into _collision_events
+        void                drain_collision_events();
+
+        SceneQuery          _scene_query;
+        // PhysicsWorld::moves() at the last scene query build
+        uint64_t            _scene_query_moves{ 0 };
+    };
+}
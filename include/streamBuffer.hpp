@@ -0,0 +1,52 @@
+#pragma once
+#include <GL/glew.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace my_gl {
+    struct StreamAllocation {
+        std::byte*      data;
+        // from the start of the buffer, what draws reference
+        std::size_t     byte_offset;
+    };
+
+    // ring of REGIONS_COUNT regions, one per frame in flight, written by the cpu while
+    // the gpu reads the previous ones. with buffer storage the buffer stays mapped and a region
+    // is reused once the fence of the frame that last used it is signaled,
+    // without it every frame orphans the buffer and maps it again, the driver does the rotation
+    class StreamBuffer {
+    public:
+        static constexpr std::size_t REGIONS_COUNT{ 3 };
+
+        StreamBuffer(std::size_t region_byte_size);
+        StreamBuffer(const StreamBuffer& rhs) = delete;
+        StreamBuffer& operator=(const StreamBuffer& rhs) = delete;
+        ~StreamBuffer();
+
+        // waits until the next region is free, regions grow to fit frame_byte_size
+        void                begin_frame(std::size_t frame_byte_size);
+        // byte_alignment must be a power of 2, the frame must have been begun big enough
+        StreamAllocation    allocate(std::size_t byte_size, std::size_t byte_alignment);
+        // writes are visible to gl after this, draws reading them can be issued
+        void                finish_writes();
+        // after the draws reading the region, fences it
+        void                end_frame();
+
+        uint32_t            id() const { return _id; }
+        bool                is_persistent() const { return _is_persistent; }
+
+    private:
+        void                create(std::size_t region_byte_size);
+        void                destroy();
+
+        std::array<GLsync, REGIONS_COUNT>   _fences{};
+        std::byte*                          _mapped{ nullptr };
+        std::size_t                         _region_byte_size{ 0 };
+        std::size_t                         _region{ 0 };
+        std::size_t                         _head{ 0 };
+        std::size_t                         _end{ 0 };
+        uint32_t                            _id{ 0 };
+        bool                                _is_persistent{ false };
+    };
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace my_gl {
+    // fixed set of workers for data parallel loops,
+    // calling thread takes part in the work as worker 0
+    class ThreadPool {
+    public:
+        // [begin, end) range of a chunk and index of the worker running it
+        using Job = std::function<void(std::size_t begin, std::size_t end, uint32_t worker)>;
+
+        // thread_count includes the calling thread, 0 uses all hardware threads
+        explicit ThreadPool(uint32_t thread_count = 0);
+        ThreadPool(const ThreadPool& rhs) = delete;
+        ThreadPool& operator=(const ThreadPool& rhs) = delete;
+        ~ThreadPool();
+
+        // splits [0, count) into chunks of chunk_size and blocks until all of them are done,
+        // chunks go to whatever worker is free, so job must not depend on the assignment
+        void parallel_for(std::size_t count, std::size_t chunk_size, const Job& job);
+        uint32_t size() const { return static_cast<uint32_t>(_workers.size()) + 1; }
+
+    private:
+        void worker_loop(uint32_t worker);
+        void run_chunks(uint32_t worker);
+
+        std::vector<std::thread>    _workers;
+        std::mutex                  _mutex;
+        std::condition_variable     _start_cv;
+        std::condition_variable     _done_cv;
+        const Job*                  _job{ nullptr };
+        std::size_t                 _count{ 0 };
+        std::size_t                 _chunk_size{ 1 };
+        std::atomic<std::size_t>    _next_chunk{ 0 };
+        uint32_t                    _busy_workers{ 0 };
+        uint64_t                    _generation{ 0 };
+        bool                        _stop{ false };
+    };
+}
@@ -0,0 +1,118 @@
+#pragma once
+// chrome trace event recording, compiled in with MY_GL_TRACING (make TRACE=1),
+// without it the macros below expand to nothing and none of this exists
+
+#ifdef MY_GL_TRACING
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace my_gl {
+    struct TraceEvent {
+        const char*     name;
+        // from the start of the recorder
+        uint64_t        timestamp_ns;
+        bool            is_begin;
+    };
+
+    // events of a single thread, single producer single consumer ring,
+    // the writer drains it while its thread keeps recording, events that don't fit are dropped
+    class TraceBuffer {
+    public:
+        static constexpr std::size_t CAPACITY{ 1 << 16 };
+
+        TraceBuffer(uint32_t thread_id);
+
+        // owning thread only
+        void    push(const char* name, uint64_t timestamp_ns, bool is_begin);
+        // writer only, appends the events since the last drain
+        void    drain(std::vector<TraceEvent>& out);
+
+        const uint32_t              _thread_id;
+        // set by the owning thread before it records
+        std::atomic<const char*>    _thread_name{ nullptr };
+        std::atomic<uint64_t>       _dropped{ 0 };
+
+    private:
+        std::vector<TraceEvent>     _events;
+        std::atomic<uint64_t>       _head{ 0 };
+        std::atomic<uint64_t>       _tail{ 0 };
+    };
+
+    // a buffer per thread, created on the first event of the thread,
+    // flushes write what was recorded since the previous one to a json file on their own thread,
+    // names must outlive the recorder, string literals are expected
+    class TraceRecorder {
+    public:
+        TraceRecorder();
+        TraceRecorder(const TraceRecorder& rhs) = delete;
+        TraceRecorder& operator=(const TraceRecorder& rhs) = delete;
+        // waits for the flush in progress
+        ~TraceRecorder();
+
+        void    begin(const char* name);
+        void    end();
+        // shown for the thread in the trace viewer
+        void    set_thread_name(const char* name);
+        // flushes by itself once _flush_after_frames frames ended
+        void    end_frame();
+        // ignored while the previous flush is still writing,
+        // the n-th flush writes <_path>_<n>.json
+        void    request_flush();
+        // waits for the flush in progress, then writes the rest on the calling thread, for the exit
+        void    flush();
+
+        // nothing is recorded while false, set before any thread records
+        bool            _enabled{ false };
+        std::string     _path{ "trace" };
+        // 0 flushes only when requested
+        uint64_t        _flush_after_frames{ 0 };
+
+    private:
+        TraceBuffer&    thread_buffer();
+        uint64_t        now_ns() const;
+        // the ones created so far, threads may add more while they are written
+        std::vector<TraceBuffer*>   buffers();
+        void            write(std::vector<TraceBuffer*> buffers, std::string path);
+
+        const std::chrono::steady_clock::time_point     _start;
+        std::mutex                                      _buffers_mutex;
+        std::vector<std::unique_ptr<TraceBuffer>>       _buffers;
+        std::thread                                     _writer;
+        std::atomic<bool>                               _is_writing{ false };
+        uint64_t                                        _frames{ 0 };
+        uint32_t                                        _flushes{ 0 };
+    };
+
+    // begin and end events around the block
+    class TraceScope {
+    public:
+        explicit TraceScope(const char* name);
+        TraceScope(const TraceScope& rhs) = delete;
+        TraceScope& operator=(const TraceScope& rhs) = delete;
+        ~TraceScope();
+    };
+
+    namespace globals {
+        // defined with the recorder, headless builds have it without the rest of the globals
+        extern TraceRecorder tracer;
+    }
+}
+
+#define MY_GL_TRACE_CONCAT_IMPL(a, b) a##b
+#define MY_GL_TRACE_CONCAT(a, b) MY_GL_TRACE_CONCAT_IMPL(a, b)
+#define MY_GL_TRACE_SCOPE(name) const my_gl::TraceScope MY_GL_TRACE_CONCAT(trace_scope_, __LINE__){ name }
+#define MY_GL_TRACE_THREAD_NAME(name) my_gl::globals::tracer.set_thread_name(name)
+
+#else
+
+#define MY_GL_TRACE_SCOPE(name)
+#define MY_GL_TRACE_THREAD_NAME(name)
+
+#endif
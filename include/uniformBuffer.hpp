@@ -0,0 +1,71 @@
+#pragma once
+#include <GL/glew.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace my_gl {
+    // blocks shared by all programs, a program binds the ones it declares on creation,
+    // so data written once is seen by every shader
+    struct UniformBlock {
+        // this enum is also an index for names
+        enum Binding : uint32_t {
+            FRAME_DATA,
+            MATERIAL_TABLE,
+            // per draw, a range of the stream buffer is bound to it before each draw
+            OBJECT_DATA,
+
+            COUNT
+        };
+
+        static constexpr std::array<const char*, COUNT> names{ "FrameData", "MaterialTable", "ObjectData" };
+    };
+
+    // std140 layouts, vec3 is aligned as vec4, so each one is followed by padding
+    // or by a scalar, matrices are declared row_major in the blocks
+    struct FrameDataStd140 {
+        std::array<float, 16>   view_mat;
+        std::array<float, 16>   proj_mat;
+        std::array<float, 16>   view_proj_mat;
+        std::array<float, 4>    view_pos;
+        std::array<float, 4>    light_position;
+        std::array<float, 4>    light_ambient;
+        std::array<float, 4>    light_diffuse;
+        std::array<float, 4>    light_specular;
+    };
+    static_assert(sizeof(FrameDataStd140) == 272, "FrameData block layout changed");
+
+    struct MaterialStd140 {
+        std::array<float, 4>    ambient;
+        std::array<float, 4>    diffuse;
+        std::array<float, 3>    specular;
+        float                   shininess;
+    };
+    static_assert(sizeof(MaterialStd140) == 48, "Material layout changed");
+
+    struct ObjectDataStd140 {
+        std::array<float, 16>   model_view_mat;
+        std::array<float, 16>   normal_mat;
+        std::array<float, 16>   mvp_mat;
+        int32_t                 material_index;
+        std::array<int32_t, 3>  padding;
+    };
+    static_assert(sizeof(ObjectDataStd140) == 208, "ObjectData block layout changed");
+
+    class UniformBuffer {
+    public:
+        // storage is allocated and bound to the binding point right away
+        UniformBuffer(UniformBlock::Binding binding, std::size_t byte_size, GLenum usage);
+        UniformBuffer(const UniformBuffer& rhs) = delete;
+        UniformBuffer& operator=(const UniformBuffer& rhs) = delete;
+        ~UniformBuffer();
+
+        void upload(const void* data, std::size_t byte_size) const;
+        template<typename T>
+        void upload(const T& data) const { upload(&data, sizeof(T)); }
+
+    private:
+        uint32_t        _id{ 0 };
+        std::size_t     _byte_size;
+    };
+}
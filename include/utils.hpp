@@ -2,6 +2,7 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <concepts>
+#include "replay.hpp"
 #include "vec.hpp"
 #include "window.hpp"
 
@@ -9,6 +10,8 @@ namespace my_gl {
     my_gl::Window init_window();
     void          init_GLFW();
     void          init_GLEW();
+    // state every context starts with, after glew is initialized
+    void          init_gl_state();
     GLuint        create_shader(GLenum shaderType, const char* filePath);
     GLuint        create_program(const char* vertexShaderFilePath, const char* fragmentShaderFilePath);    
     void          callback_debug_message(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* msg, const void* data);
@@ -16,6 +19,8 @@ namespace my_gl {
     void          callback_keyboard(GLFWwindow* window, int key, int scancode, int action, int mode);
     void          callback_mouse_move(GLFWwindow* window, double xpos, double ypos);
     void          callback_scroll(GLFWwindow* window, double xoffset, double yoffset);
+    // what callbacks do with the input, also used to play recorded input, window may be null
+    void          apply_input(GLFWwindow* window, const InputEvent& event);
     void          print_max_vert_attrs_supported();
 
     template<typename Tag, typename Value>
@@ -19,26 +19,45 @@ struct Material {
     float shininess;
 };
 
-uniform vec3 u_view_pos;
-uniform Material u_material;
-uniform Light u_light;
+layout(std140, row_major) uniform FrameData {
+    mat4 view_mat;
+    mat4 proj_mat;
+    mat4 view_proj_mat;
+    vec3 view_pos;
+    Light light;
+} u_frame;
+
+layout(std140) uniform MaterialTable {
+    // Material::COUNT entries
+    Material materials[7];
+} u_material_table;
+
+layout(std140, row_major) uniform ObjectData {
+    mat4 model_view_mat;
+    mat4 normal_mat;
+    mat4 mvp_mat;
+    int material_index;
+} u_object;
+
 // uniform float u_lerp;
 
 void main() {
+    Material material = u_material_table.materials[u_object.material_index];
+
     // ambient
-    vec3 ambient_vec = u_light.ambient * u_material.ambient;
+    vec3 ambient_vec = u_frame.light.ambient * material.ambient;
 
     // diffuse
     vec3 normal_normalized = normalize(passed_normal);
-    vec3 light_dir = normalize(u_light.position - passed_frag_pos);
+    vec3 light_dir = normalize(u_frame.light.position - passed_frag_pos);
     float diffuse_coef = max(dot(light_dir, normal_normalized), 0.0);
-    vec3 diffuse_vec = u_light.diffuse * (u_material.diffuse * diffuse_coef);
+    vec3 diffuse_vec = u_frame.light.diffuse * (material.diffuse * diffuse_coef);
 
     // specular
-    vec3 view_dir = normalize(u_view_pos - passed_frag_pos);
+    vec3 view_dir = normalize(u_frame.view_pos - passed_frag_pos);
     vec3 reflect_dir = reflect(-light_dir, normal_normalized);
-    float specular_coef = pow(max(dot(reflect_dir, view_dir), 0.0), u_material.shininess);
-    vec3 spectular_vec = u_light.specular * (u_material.specular * specular_coef);
+    float specular_coef = pow(max(dot(reflect_dir, view_dir), 0.0), material.shininess);
+    vec3 spectular_vec = u_frame.light.specular * (material.specular * specular_coef);
 
     vec3 light_color_result = ambient_vec + diffuse_vec + spectular_vec;
     output_color = vec4(light_color_result, 1.0);
@@ -0,0 +1,58 @@
+#version 330
+
+smooth in vec3 passed_normal;
+smooth in vec3 passed_frag_pos;
+flat in uint passed_material;
+
+out vec4 output_color;
+
+struct Light {
+    vec3 position;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct Material {
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float shininess;
+};
+
+layout(std140, row_major) uniform FrameData {
+    mat4 view_mat;
+    mat4 proj_mat;
+    mat4 view_proj_mat;
+    vec3 view_pos;
+    Light light;
+} u_frame;
+
+layout(std140) uniform MaterialTable {
+    // Material::COUNT entries
+    Material materials[7];
+} u_material_table;
+
+// uniform float u_lerp;
+
+void main() {
+    Material material = u_material_table.materials[passed_material];
+
+    // ambient
+    vec3 ambient_vec = u_frame.light.ambient * material.ambient;
+
+    // diffuse
+    vec3 normal_normalized = normalize(passed_normal);
+    vec3 light_dir = normalize(u_frame.light.position - passed_frag_pos);
+    float diffuse_coef = max(dot(light_dir, normal_normalized), 0.0);
+    vec3 diffuse_vec = u_frame.light.diffuse * (material.diffuse * diffuse_coef);
+
+    // specular
+    vec3 view_dir = normalize(u_frame.view_pos - passed_frag_pos);
+    vec3 reflect_dir = reflect(-light_dir, normal_normalized);
+    float specular_coef = pow(max(dot(reflect_dir, view_dir), 0.0), material.shininess);
+    vec3 spectular_vec = u_frame.light.specular * (material.specular * specular_coef);
+
+    vec3 light_color_result = ambient_vec + diffuse_vec + spectular_vec;
+    output_color = vec4(light_color_result, 1.0);
+}
@@ -4,9 +4,12 @@ layout(location = 0) in vec3 a_pos;
 layout(location = 1) in vec3 a_color;
 layout(location = 2) in vec3 a_normal;
 
-uniform mat4 u_model_view_mat;
-uniform mat4 u_normal_mat;
-uniform mat4 u_mvp_mat;
+layout(std140, row_major) uniform ObjectData {
+    mat4 model_view_mat;
+    mat4 normal_mat;
+    mat4 mvp_mat;
+    int material_index;
+} u_object;
 
 flat    out vec3 passed_color;
 smooth  out vec3 passed_normal;
@@ -14,8 +17,8 @@ smooth  out vec3 passed_frag_pos;
 
 void main() {
     vec4 a_pos_homogen      =   vec4(a_pos, 1.0);
-    gl_Position             =   u_mvp_mat * a_pos_homogen;
-    passed_frag_pos         =   vec3(u_model_view_mat * a_pos_homogen);
+    gl_Position             =   u_object.mvp_mat * a_pos_homogen;
+    passed_frag_pos         =   vec3(u_object.model_view_mat * a_pos_homogen);
     passed_color            =   a_color;
-    passed_normal           =   mat3(u_normal_mat) * a_normal;
+    passed_normal           =   mat3(u_object.normal_mat) * a_normal;
 }
@@ -2,8 +2,13 @@
 
 layout(location = 0) in vec3 a_pos;
 
-uniform mat4 u_mvp_mat;
+layout(std140, row_major) uniform ObjectData {
+    mat4 model_view_mat;
+    mat4 normal_mat;
+    mat4 mvp_mat;
+    int material_index;
+} u_object;
 
 void main() {
-    gl_Position = u_mvp_mat * vec4(a_pos, 1.0);
+    gl_Position = u_object.mvp_mat * vec4(a_pos, 1.0);
 }
@@ -0,0 +1,45 @@
+#version 330
+
+layout(location = 0) in vec3 a_pos;
+layout(location = 1) in vec3 a_normal;
+// per instance, takes locations 2 to 5
+layout(location = 2) in mat4 a_model_mat;
+layout(location = 6) in uint a_material;
+
+struct Light {
+    vec3 position;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+layout(std140, row_major) uniform FrameData {
+    mat4 view_mat;
+    mat4 proj_mat;
+    mat4 view_proj_mat;
+    vec3 view_pos;
+    Light light;
+} u_frame;
+
+smooth out vec3 passed_normal;
+smooth out vec3 passed_frag_pos;
+flat out uint passed_material;
+
+void main() {
+    vec4 a_pos_homogen = vec4(a_pos, 1.0);
+    mat4 model_view_mat = u_frame.view_mat * a_model_mat;
+    gl_Position = u_frame.view_proj_mat * (a_model_mat * a_pos_homogen);
+    passed_frag_pos = vec3(model_view_mat * a_pos_homogen);
+    // the inverse transpose of the model 3x3 times its determinant has the cross products of
+    // the other two columns as columns, the fragment shader normalizes, so only the sign of the
+    // determinant is kept, still right for non uniform scales, the look at view matrix is rigid
+    mat3 model_mat3 = mat3(a_model_mat);
+    mat3 cofactor_mat = mat3(
+        cross(model_mat3[1], model_mat3[2]),
+        cross(model_mat3[2], model_mat3[0]),
+        cross(model_mat3[0], model_mat3[1])
+    );
+    float det_sign = sign(dot(cofactor_mat[0], model_mat3[0]));
+    passed_normal = mat3(u_frame.view_mat) * (cofactor_mat * a_normal * det_sign);
+    passed_material = a_material;
+}
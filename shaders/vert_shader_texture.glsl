@@ -3,11 +3,16 @@
 layout(location = 0) in vec3 a_position;
 layout(location = 2) in vec2 a_tex_coord;
 
-uniform mat4 u_mvp_mat;
+layout(std140, row_major) uniform ObjectData {
+    mat4 model_view_mat;
+    mat4 normal_mat;
+    mat4 mvp_mat;
+    int material_index;
+} u_object;
 
 out vec2 tex_coord;
 
 void main() {
-    gl_Position = u_mvp_mat * vec4(a_position, 1.0);
+    gl_Position = u_object.mvp_mat * vec4(a_position, 1.0);
     tex_coord = a_tex_coord;
 }
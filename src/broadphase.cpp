@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "broadphase.hpp"
+
+namespace {
+    // how much more spread another axis needs before the proxies are sorted on it
+    constexpr double SWITCH_AXIS_VARIANCE_RATIO{ 1.5 };
+    // band width in median body sizes, wider bands walk more bodies, narrower ones copy more of them
+    constexpr float BAND_WIDTH_RATIO{ 2.0f };
+    // sleeping bodies longer than this many bands on the sweep axis (floors, walls) aren't looked up
+    // by the awake ones, the lookup window would have to be as long as they are
+    constexpr float LARGE_EXTENT_BANDS{ 4.0f };
+
+    bool has_bounds(const float* min, const float* max) {
+        return min[0] <= max[0];
+    }
+}
+
+void my_gl::Broadphase::find_pairs(
+    const SoAVec3&              bounds_min,
+    const SoAVec3&              bounds_max,
+    const std::vector<float>&   awake,
+    float                       margin,
+    std::vector<BodyPair>&      out_pairs
+)
+{
+    out_pairs.clear();
+
+    const bool is_added{ _is_listed_awake.size() < awake.size() };
+    const std::size_t sorted_count{ update_lists(bounds_min, bounds_max, awake) };
+    const bool is_sleeping_changed{ _is_sleeping_dirty || _is_sleeping_removed || !_fell_asleep.empty() };
+    _is_sleeping_removed = false;
+    const uint32_t prev_axis{ _axis };
+    const bool is_axis_changed{ choose_axes() };
+    const bool is_resorted{ _axis != prev_axis };
+    sort_proxies(_awake_proxies, sorted_count, is_resorted);
+
+    if (_is_sleeping_dirty) {
+        for (Proxy& proxy : _sleeping_proxies) {
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                proxy.min[axis] = bounds_min[axis][proxy.body];
+                proxy.max[axis] = bounds_max[axis][proxy.body];
+            }
+        }
+    }
+    if (is_sleeping_changed || is_axis_changed) {
+        const std::size_t sleeping_sorted_count{ _sleeping_proxies.size() };
+        _sleeping_proxies.insert(_sleeping_proxies.end(), _fell_asleep.begin(), _fell_asleep.end());
+        _fell_asleep.clear();
+        sort_proxies(_sleeping_proxies, sleeping_sorted_count, is_resorted || _is_sleeping_dirty);
+        _is_sleeping_dirty = false;
+    }
+
+    // awake bodies leaving the bands are clamped into the outer ones, still correct, only slower,
+    // the layout follows them the next time the sleeping ones are sorted anyway
+    if (is_added || is_sleeping_changed || is_axis_changed) {
+        update_band_layout(margin);
+        split_sleeping();
+        fill_bands(_regular_proxies, margin, _sleeping_band_proxies, _sleeping_band_starts);
+    }
+    fill_bands(_awake_proxies, margin, _awake_band_proxies, _awake_band_starts);
+
+    _awake_max_extent = 0.0f;
+    for (const Proxy& proxy : _awake_proxies) {
+        _awake_max_extent = std::max(_awake_max_extent, proxy.max[_axis] - proxy.min[_axis]);
+    }
+    sweep_awake(margin, out_pairs);
+    sweep_sleeping(margin, out_pairs);
+
+    // deterministic order, independent from the sweep order
+    std::sort(out_pairs.begin(), out_pairs.end(), [](const BodyPair& lhs, const BodyPair& rhs) {
+        return lhs.key() < rhs.key();
+    });
+}
+
+void my_gl::Broadphase::wake(BodyId body) {
+    _woken.push_back(body);
+}
+
+void my_gl::Broadphase::bounds_changed(BodyId body) {
+    // awake ones are copied every step anyway
+    if (body < _is_listed_awake.size() && !_is_listed_awake[body]) {
+        _is_sleeping_dirty = true;
+    }
+}
+
+std::size_t my_gl::Broadphase::update_lists(const SoAVec3& bounds_min, const SoAVec3& bounds_max, const std::vector<float>& awake) {
+    // removing keeps the rest in order
+    std::erase_if(_awake_proxies, [&](const Proxy& proxy) {
+        if (awake[proxy.body] != 0.0f) {
+            return false;
+        }
+        _is_listed_awake[proxy.body] = 0;
+        _fell_asleep.push_back(proxy);
+        return true;
+    });
+    const std::size_t sorted_count{ _awake_proxies.size() };
+
+    bool is_woken{ false };
+    for (const BodyId body : _woken) {
+        if (body < _is_listed_awake.size() && !_is_listed_awake[body] && awake[body] != 0.0f) {
+            _is_listed_awake[body] = 1;
+            _awake_proxies.push_back(Proxy{ .body = body });
+            is_woken = true;
+        }
+    }
+    _woken.clear();
+    if (is_woken) {
+        // removing keeps them sorted, only their bands are filled again
+        std::erase_if(_sleeping_proxies, [this](const Proxy& proxy) { return _is_listed_awake[proxy.body] != 0; });
+        _is_sleeping_removed = true;
+    }
+
+    for (BodyId body = static_cast<BodyId>(_is_listed_awake.size()); body < awake.size(); ++body) {
+        const bool is_awake{ awake[body] != 0.0f };
+        _is_listed_awake.push_back(is_awake ? 1 : 0);
+        (is_awake ? _awake_proxies : _fell_asleep).push_back(Proxy{ .body = body });
+    }
+
+    for (std::vector<Proxy>* proxies : { &_awake_proxies, &_fell_asleep }) {
+        for (Proxy& proxy : *proxies) {
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                proxy.min[axis] = bounds_min[axis][proxy.body];
+                proxy.max[axis] = bounds_max[axis][proxy.body];
+            }
+        }
+    }
+
+    return sorted_count;
+}
+
+// variance of awake box centers, axes are only switched once another one is clearly better,
+// so bodies spread evenly on two axes don't resort every step, returns true when either was switched
+bool my_gl::Broadphase::choose_axes() {
+    double sum[3]{ 0.0, 0.0, 0.0 };
+    double sum_sq[3]{ 0.0, 0.0, 0.0 };
+    std::size_t count{ 0 };
+    for (const Proxy& proxy : _awake_proxies) {
+        if (!has_bounds(proxy.min, proxy.max)) {
+            continue;
+        }
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            const double center{ 0.5 * (static_cast<double>(proxy.min[axis]) + proxy.max[axis]) };
+            sum[axis] += center;
+            sum_sq[axis] += center * center;
+        }
+        ++count;
+    }
+    if (count == 0) {
+        return false;
+    }
+
+    double variance[3];
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        const double mean{ sum[axis] / count };
+        variance[axis] = sum_sq[axis] / count - mean * mean;
+    }
+    const uint32_t prev_axis{ _axis };
+    const uint32_t prev_band_axis{ _band_axis };
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        if (variance[axis] > variance[_axis] * SWITCH_AXIS_VARIANCE_RATIO) {
+            _axis = axis;
+        }
+    }
+    if (_band_axis == _axis) {
+        const uint32_t axis_1{ (_axis + 1) % 3 };
+        const uint32_t axis_2{ (_axis + 2) % 3 };
+        _band_axis = variance[axis_1] >= variance[axis_2] ? axis_1 : axis_2;
+    }
+    else if (const uint32_t other_axis{ 3 - _axis - _band_axis }; variance[other_axis] > variance[_band_axis] * SWITCH_AXIS_VARIANCE_RATIO) {
+        _band_axis = other_axis;
+    }
+    return _axis != prev_axis || _band_axis != prev_band_axis;
+}
+
+// the first sorted_count proxies are in the order of the last step, it is almost right,
+// so insertion sort is almost linear, appended ones are sorted apart and merged in,
+// a new axis sorts all of them again
+void my_gl::Broadphase::sort_proxies(std::vector<Proxy>& proxies, std::size_t sorted_count, bool is_resorted) const {
+    const uint32_t axis{ _axis };
+    // ties by id, so the order doesn't depend on the previous one
+    const auto less{ [axis](const Proxy& lhs, const Proxy& rhs) {
+        return lhs.min[axis] < rhs.min[axis] || (lhs.min[axis] == rhs.min[axis] && lhs.body < rhs.body);
+    } };
+    if (is_resorted) {
+        std::sort(proxies.begin(), proxies.end(), less);
+        return;
+    }
+
+    for (std::size_t i = 1; i < sorted_count; ++i) {
+        const Proxy proxy{ proxies[i] };
+        std::size_t j{ i };
+        while (j > 0 && proxies[j - 1].min[axis] > proxy.min[axis]) {
+            proxies[j] = proxies[j - 1];
+            --j;
+        }
+        proxies[j] = proxy;
+    }
+    if (sorted_count < proxies.size()) {
+        std::sort(proxies.begin() + sorted_count, proxies.end(), less);
+        std::inplace_merge(proxies.begin(), proxies.begin() + sorted_count, proxies.end(), less);
+    }
+}
+
+// bands as wide as a few median bodies over the range of all bodies, big ones span many
+void my_gl::Broadphase::update_band_layout(float margin) {
+    const uint32_t axis{ _band_axis };
+    _extents.clear();
+    float range_min{ std::numeric_limits<float>::max() };
+    float range_max{ std::numeric_limits<float>::lowest() };
+    for (const std::vector<Proxy>* proxies : { &_awake_proxies, &_sleeping_proxies }) {
+        for (const Proxy& proxy : *proxies) {
+            if (has_bounds(proxy.min, proxy.max)) {
+                _extents.push_back(proxy.max[axis] - proxy.min[axis]);
+                range_min = std::min(range_min, proxy.min[axis]);
+                range_max = std::max(range_max, proxy.max[axis]);
+            }
+        }
+    }
+
+    _band_origin = 0.0f;
+    _band_width = std::numeric_limits<float>::max();
+    _band_count = 1;
+    if (_extents.empty()) {
+        return;
+    }
+    const auto median{ _extents.begin() + _extents.size() / 2 };
+    std::nth_element(_extents.begin(), median, _extents.end());
+    const float width{ (*median + margin) * BAND_WIDTH_RATIO };
+    const float range{ range_max - range_min };
+    if (width > 0.0f && range > width) {
+        _band_origin = range_min;
+        _band_width = width;
+        // never more bands than bodies
+        _band_count = static_cast<uint32_t>(std::min(std::ceil(range / width), static_cast<float>(_extents.size())));
+    }
+}
+
+// proxies are distributed in sweep order, so every band stays sorted
+void my_gl::Broadphase::fill_bands(
+    std::vector<Proxy>&     proxies,
+    float                   margin,
+    std::vector<Proxy>&     band_proxies,
+    std::vector<uint32_t>&  band_starts
+)
+{
+    const uint32_t axis{ _band_axis };
+    band_starts.assign(_band_count + 1, 0);
+    for (Proxy& proxy : proxies) {
+        if (!has_bounds(proxy.min, proxy.max)) {
+            continue;
+        }
+        proxy.band = band_of(proxy.min[axis]);
+        for (uint32_t band = proxy.band, last = band_of(proxy.max[axis] + margin); band <= last; ++band) {
+            ++band_starts[band + 1];
+        }
+    }
+    for (uint32_t band = 0; band < _band_count; ++band) {
+        band_starts[band + 1] += band_starts[band];
+    }
+
+    band_proxies.resize(band_starts[_band_count]);
+    _band_fill.assign(band_starts.begin(), band_starts.end() - 1);
+    for (const Proxy& proxy : proxies) {
+        if (!has_bounds(proxy.min, proxy.max)) {
+            continue;
+        }
+        for (uint32_t band = proxy.band, last = band_of(proxy.max[axis] + margin); band <= last; ++band) {
+            band_proxies[_band_fill[band]++] = proxy;
+        }
+    }
+}
+
+void my_gl::Broadphase::split_sleeping() {
+    const float large_extent{ _band_width * LARGE_EXTENT_BANDS };
+    _regular_proxies.clear();
+    _large_proxies.clear();
+    _sleeping_max_extent = 0.0f;
+    for (const Proxy& proxy : _sleeping_proxies) {
+        const float extent{ proxy.max[_axis] - proxy.min[_axis] };
+        if (extent > large_extent) {
+            _large_proxies.push_back(proxy);
+            _large_proxies.back().band = band_of(proxy.min[_band_axis]);
+        }
+        else {
+            _regular_proxies.push_back(proxy);
+            _sleeping_max_extent = std::max(_sleeping_max_extent, extent);
+        }
+    }
+}
+
+uint32_t my_gl::Broadphase::band_of(float coord) const {
+    const float band{ std::floor((coord - _band_origin) / _band_width) };
+    return static_cast<uint32_t>(std::clamp(band, 0.0f, static_cast<float>(_band_count - 1)));
+}
+
+// awake ones against the awake ones after them in the band, and against the regular sleeping ones
+// of the band starting no further before them than the longest of those
+void my_gl::Broadphase::sweep_awake(float margin, std::vector<BodyPair>& out_pairs) const {
+    const uint32_t axis{ _axis };
+    const auto min_less{ [axis](const Proxy& proxy, float value) { return proxy.min[axis] < value; } };
+
+    for (uint32_t band = 0; band < _band_count; ++band) {
+        const auto sleeping_begin{ _sleeping_band_proxies.begin() + _sleeping_band_starts[band] };
+        const auto sleeping_end{ _sleeping_band_proxies.begin() + _sleeping_band_starts[band + 1] };
+        const uint32_t end{ _awake_band_starts[band + 1] };
+        for (uint32_t i = _awake_band_starts[band]; i < end; ++i) {
+            const Proxy& a{ _awake_band_proxies[i] };
+            const float sweep_max{ a.max[axis] + margin };
+
+            for (uint32_t j = i + 1; j < end; ++j) {
+                const Proxy& b{ _awake_band_proxies[j] };
+                if (b.min[axis] > sweep_max) {
+                    break;
+                }
+                if (overlaps(a, b, margin) && std::max(a.band, b.band) == band) {
+                    out_pairs.push_back(a.body < b.body ? BodyPair{ a.body, b.body } : BodyPair{ b.body, a.body });
+                }
+            }
+
+            const float window_min{ a.min[axis] - margin - _sleeping_max_extent };
+            for (auto it = std::lower_bound(sleeping_begin, sleeping_end, window_min, min_less); it != sleeping_end; ++it) {
+                if (it->min[axis] > sweep_max) {
+                    break;
+                }
+                if (overlaps(a, *it, margin) && std::max(a.band, it->band) == band) {
+                    out_pairs.push_back(a.body < it->body ? BodyPair{ a.body, it->body } : BodyPair{ it->body, a.body });
+                }
+            }
+        }
+    }
+}
+
+// large sleeping ones against the awake ones in each band they span
+void my_gl::Broadphase::sweep_sleeping(float margin, std::vector<BodyPair>& out_pairs) const {
+    const uint32_t axis{ _axis };
+    const auto min_less{ [axis](const Proxy& proxy, float value) { return proxy.min[axis] < value; } };
+
+    for (const Proxy& large : _large_proxies) {
+        const float window_min{ large.min[axis] - margin - _awake_max_extent };
+        const float sweep_max{ large.max[axis] + margin };
+        for (uint32_t band = large.band, last = band_of(large.max[_band_axis] + margin); band <= last; ++band) {
+            const auto awake_begin{ _awake_band_proxies.begin() + _awake_band_starts[band] };
+            const auto awake_end{ _awake_band_proxies.begin() + _awake_band_starts[band + 1] };
+            for (auto it = std::lower_bound(awake_begin, awake_end, window_min, min_less); it != awake_end; ++it) {
+                if (it->min[axis] > sweep_max) {
+                    break;
+                }
+                if (overlaps(large, *it, margin) && std::max(large.band, it->band) == band) {
+                    out_pairs.push_back(large.body < it->body ? BodyPair{ large.body, it->body } : BodyPair{ it->body, large.body });
+                }
+            }
+        }
+    }
+}
+
+bool my_gl::Broadphase::overlaps(const Proxy& a, const Proxy& b, float margin) const {
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        if (a.min[axis] > b.max[axis] + margin || a.max[axis] + margin < b.min[axis]) {
+            return false;
+        }
+    }
+    return true;
+}
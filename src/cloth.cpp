@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include "cloth.hpp"
+#include "profiler.hpp"
+#include "simd.hpp"
+#include "threadPool.hpp"
+
+namespace {
+    using my_gl::simd::F32x4;
+
+    // keeps coincident particles from dividing by zero
+    constexpr float MIN_LENGTH{ 1e-6f };
+
+    // next = pos + (pos - prev) * keep + gravity * dt^2, for a single axis,
+    // pinned particles are masked out, prev takes the old position
+    void integrate_axis(float* pos, float* prev_pos, const float* free, std::size_t count, float keep, float gravity_step) {
+        const F32x4 keep_x4{ F32x4::broadcast(keep) };
+        const F32x4 gravity_x4{ F32x4::broadcast(gravity_step) };
+        std::size_t i{ 0 };
+
+        for (; i + F32x4::width <= count; i += F32x4::width) {
+            const F32x4 curr{ F32x4::load(pos + i) };
+            const F32x4 offset{ ((curr - F32x4::load(prev_pos + i)) * keep_x4 + gravity_x4) * F32x4::load(free + i) };
+            curr.store(prev_pos + i);
+            (curr + offset).store(pos + i);
+        }
+
+        // tail
+        for (; i < count; ++i) {
+            const float curr{ pos[i] };
+            pos[i] += ((curr - prev_pos[i]) * keep + gravity_step) * free[i];
+            prev_pos[i] = curr;
+        }
+    }
+}
+
+my_gl::Cloth my_gl::Cloth::grid(uint32_t width, uint32_t height, float spacing, const math::Vec3<float>& origin) {
+    assert(width >= 2 && height >= 2 && width * height <= std::numeric_limits<uint16_t>::max() + 1u && "cloth grid doesn't fit 16 bit indices");
+
+    Cloth cloth;
+    auto index{ [width](uint32_t x, uint32_t y) { return y * width + x; } };
+
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            cloth.add_particle(origin + math::Vec3<float>{ x * spacing, -(y * spacing), 0.0f });
+        }
+    }
+    for (uint32_t x = 0; x < width; ++x) {
+        cloth.pin(index(x, 0));
+    }
+
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            // structural
+            if (x + 1 < width) {
+                cloth.add_constraint(index(x, y), index(x + 1, y));
+            }
+            if (y + 1 < height) {
+                cloth.add_constraint(index(x, y), index(x, y + 1));
+            }
+            // shear
+            if (x + 1 < width && y + 1 < height) {
+                cloth.add_constraint(index(x, y), index(x + 1, y + 1));
+                cloth.add_constraint(index(x + 1, y), index(x, y + 1));
+                cloth.add_triangle(index(x, y), index(x, y + 1), index(x + 1, y + 1));
+                cloth.add_triangle(index(x, y), index(x + 1, y + 1), index(x + 1, y));
+            }
+            // bending, soft so the cloth can still fold
+            if (x + 2 < width) {
+                cloth.add_constraint(index(x, y), index(x + 2, y), 0.2f);
+            }
+            if (y + 2 < height) {
+                cloth.add_constraint(index(x, y), index(x, y + 2), 0.2f);
+            }
+        }
+    }
+
+    return cloth;
+}
+
+uint32_t my_gl::Cloth::add_particle(const math::Vec3<float>& position, float inv_mass) {
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        _pos[axis].push_back(position[axis]);
+        _prev_pos[axis].push_back(position[axis]);
+    }
+    _inv_mass.push_back(inv_mass);
+    _free.push_back(inv_mass > 0.0f ? 1.0f : 0.0f);
+    _batches_dirty = true;
+
+    return size() - 1;
+}
+
+void my_gl::Cloth::add_constraint(uint32_t a, uint32_t b, float stiffness) {
+    assert(a < size() && b < size() && a != b && "invalid cloth constraint");
+
+    const math::Vec3<float> delta{ position(b) - position(a) };
+    _constraints.push_back(Constraint{ a, b, std::sqrt(delta.dot(delta)), std::clamp(stiffness, 0.0f, 1.0f) });
+    _batches_dirty = true;
+}
+
+void my_gl::Cloth::add_triangle(uint32_t a, uint32_t b, uint32_t c) {
+    assert(std::max({ a, b, c }) <= std::numeric_limits<uint16_t>::max() && "cloth triangle doesn't fit 16 bit indices");
+
+    _indices.push_back(static_cast<uint16_t>(a));
+    _indices.push_back(static_cast<uint16_t>(b));
+    _indices.push_back(static_cast<uint16_t>(c));
+}
+
+void my_gl::Cloth::pin(uint32_t particle, bool pinned) {
+    _free[particle] = !pinned && _inv_mass[particle] > 0.0f ? 1.0f : 0.0f;
+    _batches_dirty = true;
+}
+
+void my_gl::Cloth::set_position(uint32_t particle, const math::Vec3<float>& position) {
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        _pos[axis][particle] = position[axis];
+        _prev_pos[axis][particle] = position[axis];
+    }
+}
+
+void my_gl::Cloth::step(float step_duration) {
+    if (_batches_dirty) {
+        build_batches();
+    }
+
+    integrate(step_duration);
+
+    // gauss-seidel between batches, every batch sees corrections of the previous ones
+    for (uint32_t iteration = 0; iteration < _settings.iterations; ++iteration) {
+        for (const Batch& batch : _batches) {
+            relax_batch(batch);
+        }
+    }
+}
+
+void my_gl::Cloth::integrate(float step_duration) {
+    const float keep{ 1.0f - _settings.damping };
+    const float step_sq{ step_duration * step_duration };
+
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        integrate_axis(_pos[axis].data(), _prev_pos[axis].data(), _free.data(), size(), keep, _settings.gravity[axis] * step_sq);
+    }
+}
+
+// moves both ends along the constraint by their share of the length error,
+// lanes gather and scatter particles, no two lanes of a batch touch the same one
+void my_gl::Cloth::relax_batch(const Batch& batch) {
+    float* const x{ _pos[0].data() };
+    float* const y{ _pos[1].data() };
+    float* const z{ _pos[2].data() };
+    const std::size_t count{ batch.a.size() };
+    const F32x4 min_length{ F32x4::broadcast(MIN_LENGTH) };
+    const F32x4 one{ F32x4::broadcast(1.0f) };
+    std::size_t i{ 0 };
+
+    for (; i + F32x4::width <= count; i += F32x4::width) {
+        alignas(16) float lanes[6][F32x4::width];
+        for (std::size_t lane = 0; lane < F32x4::width; ++lane) {
+            const uint32_t a{ batch.a[i + lane] };
+            const uint32_t b{ batch.b[i + lane] };
+            lanes[0][lane] = x[a];
+            lanes[1][lane] = y[a];
+            lanes[2][lane] = z[a];
+            lanes[3][lane] = x[b];
+            lanes[4][lane] = y[b];
+            lanes[5][lane] = z[b];
+        }
+
+        const F32x4 ax{ F32x4::load(lanes[0]) };
+        const F32x4 ay{ F32x4::load(lanes[1]) };
+        const F32x4 az{ F32x4::load(lanes[2]) };
+        const F32x4 dx{ F32x4::load(lanes[3]) - ax };
+        const F32x4 dy{ F32x4::load(lanes[4]) - ay };
+        const F32x4 dz{ F32x4::load(lanes[5]) - az };
+        const F32x4 length{ F32x4::max(F32x4::sqrt(dx * dx + dy * dy + dz * dz), min_length) };
+        // relative error, positive when stretched
+        const F32x4 error{ one - F32x4::load(batch.rest_length.data() + i) / length };
+        const F32x4 move_a{ error * F32x4::load(batch.weight_a.data() + i) };
+        const F32x4 move_b{ error * F32x4::load(batch.weight_b.data() + i) };
+
+        (ax + dx * move_a).store(lanes[0]);
+        (ay + dy * move_a).store(lanes[1]);
+        (az + dz * move_a).store(lanes[2]);
+        (F32x4::load(lanes[3]) - dx * move_b).store(lanes[3]);
+        (F32x4::load(lanes[4]) - dy * move_b).store(lanes[4]);
+        (F32x4::load(lanes[5]) - dz * move_b).store(lanes[5]);
+
+        for (std::size_t lane = 0; lane < F32x4::width; ++lane) {
+            const uint32_t a{ batch.a[i + lane] };
+            const uint32_t b{ batch.b[i + lane] };
+            x[a] = lanes[0][lane];
+            y[a] = lanes[1][lane];
+            z[a] = lanes[2][lane];
+            x[b] = lanes[3][lane];
+            y[b] = lanes[4][lane];
+            z[b] = lanes[5][lane];
+        }
+    }
+
+    // tail
+    for (; i < count; ++i) {
+        const uint32_t a{ batch.a[i] };
+        const uint32_t b{ batch.b[i] };
+        const float dx{ x[b] - x[a] };
+        const float dy{ y[b] - y[a] };
+        const float dz{ z[b] - z[a] };
+        const float length{ std::max(std::sqrt(dx * dx + dy * dy + dz * dz), MIN_LENGTH) };
+        const float error{ 1.0f - batch.rest_length[i] / length };
+        const float move_a{ error * batch.weight_a[i] };
+        const float move_b{ error * batch.weight_b[i] };
+
+        x[a] += dx * move_a;
+        y[a] += dy * move_a;
+        z[a] += dz * move_a;
+        x[b] -= dx * move_b;
+        y[b] -= dy * move_b;
+        z[b] -= dz * move_b;
+    }
+}
+
+// greedy coloring, a constraint goes to the first batch not touching its particles
+void my_gl::Cloth::build_batches() {
+    _batches.clear();
+    // particles touched by each batch
+    std::vector<std::vector<uint8_t>> used;
+
+    for (const Constraint& constraint : _constraints) {
+        const float inv_mass_a{ _inv_mass[constraint.a] * _free[constraint.a] };
+        const float inv_mass_b{ _inv_mass[constraint.b] * _free[constraint.b] };
+        const float inv_mass_sum{ inv_mass_a + inv_mass_b };
+        if (inv_mass_sum <= 0.0f) {
+            continue;
+        }
+
+        std::size_t batch_index{ 0 };
+        while (batch_index < _batches.size() && (used[batch_index][constraint.a] || used[batch_index][constraint.b])) {
+            ++batch_index;
+        }
+        if (batch_index == _batches.size()) {
+            _batches.emplace_back();
+            used.emplace_back(size(), 0);
+        }
+
+        Batch& batch{ _batches[batch_index] };
+        batch.a.push_back(constraint.a);
+        batch.b.push_back(constraint.b);
+        batch.rest_length.push_back(constraint.rest_length);
+        batch.weight_a.push_back(constraint.stiffness * inv_mass_a / inv_mass_sum);
+        batch.weight_b.push_back(constraint.stiffness * inv_mass_b / inv_mass_sum);
+        used[batch_index][constraint.a] = 1;
+        used[batch_index][constraint.b] = 1;
+    }
+
+    _batches_dirty = false;
+}
+
+void my_gl::Cloth::update_vertices() {
+    const std::size_t count{ size() };
+    _vertices.resize(count * 6);
+    float* const positions{ _vertices.data() };
+    float* const normals{ _vertices.data() + count * 3 };
+
+    for (std::size_t i = 0; i < count; ++i) {
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            positions[i * 3 + axis] = _pos[axis][i];
+        }
+    }
+
+    // area weighted sum of the normals of triangles around each particle
+    std::fill(normals, normals + count * 3, 0.0f);
+    for (std::size_t i = 0; i + 2 < _indices.size(); i += 3) {
+        const uint32_t a{ _indices[i] };
+        const uint32_t b{ _indices[i + 1] };
+        const uint32_t c{ _indices[i + 2] };
+        const math::Vec3<float> ab{ position(b) - position(a) };
+        const math::Vec3<float> ac{ position(c) - position(a) };
+        const float normal[3]{
+            ab[1] * ac[2] - ab[2] * ac[1],
+            ab[2] * ac[0] - ab[0] * ac[2],
+            ab[0] * ac[1] - ab[1] * ac[0],
+        };
+        for (const uint32_t particle : { a, b, c }) {
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                normals[particle * 3 + axis] += normal[axis];
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        float* const normal{ normals + i * 3 };
+        const float length{ std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]) };
+        if (length > MIN_LENGTH) {
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                normal[axis] /= length;
+            }
+        }
+    }
+}
+
+my_gl::meshes::Mesh my_gl::Cloth::mesh() {
+    if (_vertices.size() != size() * 6) {
+        update_vertices();
+    }
+
+    return meshes::Mesh{ .vertices = _vertices, .indices = _indices, .boundaries = nullptr };
+}
+
+void my_gl::step_cloths(std::span<Cloth> cloths, float step_duration, ThreadPool* thread_pool) {
+    const ProfileScope profile_scope{ "cloths" };
+    auto job{ [&](std::size_t begin, std::size_t end, uint32_t) {
+        for (std::size_t i = begin; i < end; ++i) {
+            cloths[i].step(step_duration);
+        }
+    } };
+
+    if (thread_pool) {
+        thread_pool->parallel_for(cloths.size(), 1, job);
+    }
+    else {
+        job(0, cloths.size(), 0);
+    }
+}
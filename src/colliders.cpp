@@ -0,0 +1,672 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+#include "colliders.hpp"
+
+namespace {
+    using my_gl::AABB;
+    using my_gl::Collider;
+    using my_gl::ContactManifold;
+    using my_gl::math::Vec3;
+
+    constexpr float EPSILON{ 1e-6f };
+
+    Vec3<float> cross(const Vec3<float>& lhs, const Vec3<float>& rhs) {
+        return lhs.cross(rhs);
+    }
+
+    Vec3<float> normalized_or(const Vec3<float>& vec, const Vec3<float>& fallback) {
+        const float length{ vec.length() };
+        return length > EPSILON ? Vec3<float>{ vec * (1.0f / length) } : fallback;
+    }
+
+    AABB world_box(const Collider& box, const Vec3<float>& position) {
+        const Vec3<float> center{ position + box.center };
+        return AABB{ .min = center - box.half_extents, .max = center + box.half_extents };
+    }
+
+    Vec3<float> closest_on_segment(const Vec3<float>& point, const Vec3<float>& start, const Vec3<float>& end) {
+        const Vec3<float> segment{ end - start };
+        const float length_sq{ segment.dot(segment) };
+        if (length_sq < EPSILON) {
+            return start;
+        }
+        const float t{ std::clamp((point - start).dot(segment) / length_sq, 0.0f, 1.0f) };
+        return start + segment * t;
+    }
+
+    // closest points of two segments, from Real-Time Collision Detection 5.1.9
+    void closest_between_segments(
+        const Vec3<float>& start_a, const Vec3<float>& end_a,
+        const Vec3<float>& start_b, const Vec3<float>& end_b,
+        Vec3<float>& point_a, Vec3<float>& point_b
+    )
+    {
+        const Vec3<float> dir_a{ end_a - start_a };
+        const Vec3<float> dir_b{ end_b - start_b };
+        const Vec3<float> offset{ start_a - start_b };
+        const float len_a{ dir_a.dot(dir_a) };
+        const float len_b{ dir_b.dot(dir_b) };
+        const float f{ dir_b.dot(offset) };
+        float s{ 0.0f };
+        float t{ 0.0f };
+
+        if (len_a < EPSILON && len_b < EPSILON) {
+            point_a = start_a;
+            point_b = start_b;
+            return;
+        }
+        if (len_a < EPSILON) {
+            t = std::clamp(f / len_b, 0.0f, 1.0f);
+        }
+        else {
+            const float c{ dir_a.dot(offset) };
+            if (len_b < EPSILON) {
+                s = std::clamp(-c / len_a, 0.0f, 1.0f);
+            }
+            else {
+                const float b{ dir_a.dot(dir_b) };
+                const float denom{ len_a * len_b - b * b };
+                // parallel segments pick any s
+                s = denom > EPSILON ? std::clamp((b * f - c * len_b) / denom, 0.0f, 1.0f) : 0.0f;
+                t = (b * s + f) / len_b;
+                if (t < 0.0f) {
+                    t = 0.0f;
+                    s = std::clamp(-c / len_a, 0.0f, 1.0f);
+                }
+                else if (t > 1.0f) {
+                    t = 1.0f;
+                    s = std::clamp((b - c) / len_a, 0.0f, 1.0f);
+                }
+            }
+        }
+
+        point_a = start_a + dir_a * s;
+        point_b = start_b + dir_b * t;
+    }
+
+    // every round shape reduces to two spheres at its closest points
+    bool spheres(const Vec3<float>& center_a, float radius_a, const Vec3<float>& center_b, float radius_b, ContactManifold& manifold, float margin) {
+        const Vec3<float> delta{ center_b - center_a };
+        const float reach{ radius_a + radius_b + margin };
+        const float dist_sq{ delta.dot(delta) };
+        if (dist_sq >= reach * reach) {
+            return false;
+        }
+
+        const float dist{ std::sqrt(dist_sq) };
+        manifold.normal = normalized_or(delta, Vec3<float>{ 0.0f, 1.0f, 0.0f });
+        manifold.depth = radius_a + radius_b - dist;
+        manifold.point = center_a + manifold.normal * (radius_a - manifold.depth * 0.5f);
+        return true;
+    }
+
+    // sphere is a, box is b
+    bool sphere_box(const Vec3<float>& center, float radius, const AABB& box, ContactManifold& manifold, float margin) {
+        Vec3<float> closest;
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            closest[axis] = std::clamp(center[axis], box.min[axis], box.max[axis]);
+        }
+
+        const Vec3<float> delta{ closest - center };
+        const float dist_sq{ delta.dot(delta) };
+
+        if (dist_sq > EPSILON * EPSILON) {
+            const float reach{ radius + margin };
+            if (dist_sq >= reach * reach) {
+                return false;
+            }
+            const float dist{ std::sqrt(dist_sq) };
+            manifold.normal = delta * (1.0f / dist);
+            manifold.depth = radius - dist;
+            manifold.point = closest;
+            return true;
+        }
+
+        // center inside, push out through the nearest face
+        float min_dist{ std::numeric_limits<float>::max() };
+        uint32_t min_axis{ 0 };
+        float face_sign{ 1.0f };
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            const float to_min{ center[axis] - box.min[axis] };
+            const float to_max{ box.max[axis] - center[axis] };
+            if (to_min < min_dist) {
+                min_dist = to_min;
+                min_axis = axis;
+                face_sign = -1.0f;
+            }
+            if (to_max < min_dist) {
+                min_dist = to_max;
+                min_axis = axis;
+                face_sign = 1.0f;
+            }
+        }
+
+        // box lies opposite to the face the sphere leaves through
+        manifold.normal = Vec3<float>{ 0.0f, 0.0f, 0.0f };
+        manifold.normal[min_axis] = -face_sign;
+        manifold.depth = radius + min_dist;
+        manifold.point = center;
+        return true;
+    }
+
+    // round shapes are a core (point or segment) swept by a sphere,
+    // gjk works on the cores, so it sees flat polytopes only and converges exactly
+    float rounding(const Collider& collider) {
+        return collider.type == Collider::Type::SPHERE || collider.type == Collider::Type::CAPSULE ? collider.radius : 0.0f;
+    }
+
+    Vec3<float> core_support(const Collider& collider, const Vec3<float>& direction) {
+        switch (collider.type) {
+            case Collider::Type::SPHERE:
+                return collider.center;
+            case Collider::Type::CAPSULE:
+                return collider.center + collider.axis * (collider.axis.dot(direction) >= 0.0f ? collider.half_height : -collider.half_height);
+            default:
+                return collider.support(direction);
+        }
+    }
+
+    // support of the minkowski difference of the cores, a - b
+    struct MinkowskiShape {
+        const Collider&     a;
+        Vec3<float>         position_a;
+        const Collider&     b;
+        Vec3<float>         position_b;
+
+        Vec3<float> support(const Vec3<float>& direction) const {
+            return position_a + core_support(a, direction) - position_b - core_support(b, direction * -1.0f);
+        }
+    };
+
+    struct Simplex {
+        std::array<Vec3<float>, 4>  points;
+        uint32_t                    count{ 0 };
+    };
+
+    // closest point to the origin on a triangle, simplex is reduced to the feature it lies on,
+    // Real-Time Collision Detection 5.1.5 with the origin as the query point
+    Vec3<float> closest_on_triangle(Simplex& simplex) {
+        const Vec3<float> a{ simplex.points[0] };
+        const Vec3<float> b{ simplex.points[1] };
+        const Vec3<float> c{ simplex.points[2] };
+        const Vec3<float> ab{ b - a };
+        const Vec3<float> ac{ c - a };
+        const Vec3<float> ap{ a * -1.0f };
+
+        const float d1{ ab.dot(ap) };
+        const float d2{ ac.dot(ap) };
+        if (d1 <= 0.0f && d2 <= 0.0f) {
+            simplex.count = 1;
+            return a;
+        }
+
+        const Vec3<float> bp{ b * -1.0f };
+        const float d3{ ab.dot(bp) };
+        const float d4{ ac.dot(bp) };
+        if (d3 >= 0.0f && d4 <= d3) {
+            simplex.points[0] = b;
+            simplex.count = 1;
+            return b;
+        }
+
+        const float vc{ d1 * d4 - d3 * d2 };
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+            simplex.count = 2;
+            return a + ab * (d1 / (d1 - d3));
+        }
+
+        const Vec3<float> cp{ c * -1.0f };
+        const float d5{ ab.dot(cp) };
+        const float d6{ ac.dot(cp) };
+        if (d6 >= 0.0f && d5 <= d6) {
+            simplex.points[0] = c;
+            simplex.count = 1;
+            return c;
+        }
+
+        const float vb{ d5 * d2 - d1 * d6 };
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+            simplex.points[1] = c;
+            simplex.count = 2;
+            return a + ac * (d2 / (d2 - d6));
+        }
+
+        const float va{ d3 * d6 - d5 * d4 };
+        if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+            simplex.points[0] = b;
+            simplex.points[1] = c;
+            simplex.count = 2;
+            return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        }
+
+        const float denom{ 1.0f / (va + vb + vc) };
+        return a + ab * (vb * denom) + ac * (vc * denom);
+    }
+
+    // false if the origin is inside of the tetrahedron
+    bool closest_on_tetrahedron(Simplex& simplex, Vec3<float>& closest) {
+        const std::array<std::array<uint32_t, 4>, 4> faces{ {
+            { 0, 1, 2, 3 },
+            { 0, 2, 3, 1 },
+            { 0, 3, 1, 2 },
+            { 1, 3, 2, 0 },
+        } };
+
+        float best_dist_sq{ std::numeric_limits<float>::max() };
+        Simplex best;
+        bool outside{ false };
+
+        for (const auto& face : faces) {
+            const Vec3<float>& a{ simplex.points[face[0]] };
+            const Vec3<float> normal{ cross(simplex.points[face[1]] - a, simplex.points[face[2]] - a) };
+            // origin and the opposite vertex on different sides of the face
+            const float origin_side{ normal.dot(a * -1.0f) };
+            const float vertex_side{ normal.dot(simplex.points[face[3]] - a) };
+            if (origin_side * vertex_side >= 0.0f) {
+                continue;
+            }
+
+            outside = true;
+            Simplex face_simplex{ { simplex.points[face[0]], simplex.points[face[1]], simplex.points[face[2]], Vec3<float>{} }, 3 };
+            const Vec3<float> point{ closest_on_triangle(face_simplex) };
+            const float dist_sq{ point.dot(point) };
+            if (dist_sq < best_dist_sq) {
+                best_dist_sq = dist_sq;
+                best = face_simplex;
+                closest = point;
+            }
+        }
+
+        if (outside) {
+            simplex = best;
+        }
+        return outside;
+    }
+
+    // closest point of the simplex to the origin, simplex is reduced to the feature it lies on,
+    // false if the simplex contains the origin
+    bool closest_on_simplex(Simplex& simplex, Vec3<float>& closest) {
+        switch (simplex.count) {
+            case 1:
+                closest = simplex.points[0];
+                return true;
+            case 2: {
+                const Vec3<float> a{ simplex.points[0] };
+                const Vec3<float> ab{ simplex.points[1] - a };
+                const float length_sq{ ab.dot(ab) };
+                const float t{ length_sq > EPSILON * EPSILON ? std::clamp(-a.dot(ab) / length_sq, 0.0f, 1.0f) : 0.0f };
+                if (t <= 0.0f) {
+                    simplex.count = 1;
+                }
+                else if (t >= 1.0f) {
+                    simplex.points[0] = simplex.points[1];
+                    simplex.count = 1;
+                }
+                closest = a + ab * t;
+                return true;
+            }
+            case 3:
+                closest = closest_on_triangle(simplex);
+                return true;
+            default:
+                return closest_on_tetrahedron(simplex, closest);
+        }
+    }
+
+    // distance between the cores, 0 if they overlap, simplex then surrounds the origin as well as it can
+    float gjk_distance(const MinkowskiShape& shape, Simplex& simplex, Vec3<float>& closest) {
+        constexpr float TOLERANCE{ 1e-4f };
+
+        Vec3<float> direction{ shape.position_a - shape.position_b };
+        if (direction.dot(direction) < EPSILON) {
+            direction = Vec3<float>{ 1.0f, 0.0f, 0.0f };
+        }
+        simplex.points[0] = shape.support(direction * -1.0f);
+        simplex.count = 1;
+        closest = simplex.points[0];
+
+        for (uint32_t iteration = 0; iteration < 64; ++iteration) {
+            const float dist_sq{ closest.dot(closest) };
+            if (dist_sq < EPSILON * EPSILON) {
+                return 0.0f;
+            }
+
+            const Vec3<float> point{ shape.support(closest * -1.0f) };
+            // no progress toward the origin, closest is final
+            if (dist_sq - closest.dot(point) <= TOLERANCE * dist_sq) {
+                break;
+            }
+            // point already spanned by the simplex can't get closer,
+            // a flat tetrahedron would also look like it contains the origin
+            bool degenerate{ false };
+            for (uint32_t i = 0; i < simplex.count; ++i) {
+                degenerate = degenerate || (simplex.points[i] - point).dot(simplex.points[i] - point) < EPSILON * EPSILON;
+            }
+            if (simplex.count == 3) {
+                const Vec3<float> normal{ normalized_or(cross(simplex.points[1] - simplex.points[0], simplex.points[2] - simplex.points[0]), Vec3<float>{ 0.0f, 0.0f, 0.0f }) };
+                degenerate = degenerate || std::abs(normal.dot(point - simplex.points[0])) < EPSILON;
+            }
+            if (degenerate) {
+                break;
+            }
+
+            simplex.points[simplex.count++] = point;
+            if (!closest_on_simplex(simplex, closest)) {
+                return 0.0f;
+            }
+        }
+
+        return closest.length();
+    }
+
+    // degenerate simplex (origin on an edge or a face) is grown into a tetrahedron for epa
+    void complete_tetrahedron(const MinkowskiShape& shape, Simplex& simplex) {
+        const std::array<Vec3<float>, 6> directions{ {
+            { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f },
+            { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+            { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+        } };
+
+        for (const Vec3<float>& direction : directions) {
+            if (simplex.count == 4) {
+                return;
+            }
+            const Vec3<float> point{ shape.support(direction) };
+            const Vec3<float> a{ simplex.points[0] };
+            bool grows{ false };
+            if (simplex.count == 1) {
+                grows = (point - a).length() > EPSILON;
+            }
+            else if (simplex.count == 2) {
+                grows = cross(simplex.points[1] - a, point - a).length() > EPSILON;
+            }
+            else {
+                const Vec3<float> normal{ cross(simplex.points[1] - a, simplex.points[2] - a) };
+                grows = std::abs(normal.dot(point - a)) > EPSILON;
+            }
+            if (grows) {
+                simplex.points[simplex.count++] = point;
+            }
+        }
+    }
+
+    // expanding polytope, finds the face of the minkowski difference closest to the origin
+    bool epa(const MinkowskiShape& shape, const Simplex& simplex, Vec3<float>& normal, float& depth) {
+        constexpr uint32_t MAX_VERTICES{ 64 };
+        constexpr uint32_t MAX_FACES{ 128 };
+        constexpr uint32_t MAX_ITERATIONS{ 32 };
+        constexpr float TOLERANCE{ 1e-4f };
+
+        struct Face {
+            uint32_t        index[3];
+            Vec3<float>     normal;
+            float           distance;
+        };
+
+        std::array<Vec3<float>, MAX_VERTICES> vertices;
+        std::array<Face, MAX_FACES> faces;
+        std::array<std::pair<uint32_t, uint32_t>, MAX_FACES> edges;
+        uint32_t vertex_count{ 4 };
+        uint32_t face_count{ 0 };
+
+        std::copy(simplex.points.begin(), simplex.points.end(), vertices.begin());
+
+        auto add_face{ [&](uint32_t i0, uint32_t i1, uint32_t i2) {
+            Vec3<float> face_normal{ cross(vertices[i1] - vertices[i0], vertices[i2] - vertices[i0]) };
+            const float length{ face_normal.length() };
+            if (length < EPSILON || face_count == MAX_FACES) {
+                return;
+            }
+            face_normal = face_normal * (1.0f / length);
+            float distance{ face_normal.dot(vertices[i0]) };
+            // origin is inside, outward normal points away from it
+            if (distance < 0.0f) {
+                face_normal = face_normal * -1.0f;
+                distance = -distance;
+                std::swap(i1, i2);
+            }
+            faces[face_count++] = Face{ { i0, i1, i2 }, face_normal, distance };
+        } };
+
+        add_face(0, 1, 2);
+        add_face(0, 3, 1);
+        add_face(0, 2, 3);
+        add_face(1, 3, 2);
+
+        for (uint32_t iteration = 0; face_count > 0; ++iteration) {
+            uint32_t closest{ 0 };
+            for (uint32_t i = 1; i < face_count; ++i) {
+                if (faces[i].distance < faces[closest].distance) {
+                    closest = i;
+                }
+            }
+
+            normal = faces[closest].normal;
+            depth = faces[closest].distance;
+
+            const Vec3<float> point{ shape.support(normal) };
+            if (point.dot(normal) - depth < TOLERANCE || iteration == MAX_ITERATIONS || vertex_count == MAX_VERTICES) {
+                return true;
+            }
+
+            // remove faces seeing the new point, their outline is the horizon
+            uint32_t edge_count{ 0 };
+            for (uint32_t i = 0; i < face_count;) {
+                const Face& face{ faces[i] };
+                if (face.normal.dot(point - vertices[face.index[0]]) <= 0.0f) {
+                    ++i;
+                    continue;
+                }
+                for (uint32_t e = 0; e < 3; ++e) {
+                    const std::pair<uint32_t, uint32_t> edge{ face.index[e], face.index[(e + 1) % 3] };
+                    // edge shared by two removed faces is inside of the hole
+                    auto shared{ std::find(edges.begin(), edges.begin() + edge_count, std::pair{ edge.second, edge.first }) };
+                    if (shared != edges.begin() + edge_count) {
+                        *shared = edges[--edge_count];
+                    }
+                    else if (edge_count < MAX_FACES) {
+                        edges[edge_count++] = edge;
+                    }
+                }
+                faces[i] = faces[--face_count];
+            }
+
+            vertices[vertex_count] = point;
+            for (uint32_t e = 0; e < edge_count; ++e) {
+                add_face(edges[e].first, edges[e].second, vertex_count);
+            }
+            ++vertex_count;
+        }
+
+        return false;
+    }
+
+    bool hulls(const Collider& a, const Vec3<float>& position_a, const Collider& b, const Vec3<float>& position_b, ContactManifold& manifold, float margin) {
+        const MinkowskiShape shape{ a, position_a, b, position_b };
+        const float radius{ rounding(a) + rounding(b) };
+        Simplex simplex;
+        Vec3<float> closest;
+        const float distance{ gjk_distance(shape, simplex, closest) };
+
+        if (distance > 0.0f) {
+            // separated cores, closest is a - b, so b lies against it
+            if (distance >= radius + margin) {
+                return false;
+            }
+            manifold.normal = closest * (-1.0f / distance);
+            manifold.depth = radius - distance;
+        }
+        else {
+            // cores overlap, the polytope is flat, so epa converges to the exact face
+            complete_tetrahedron(shape, simplex);
+            Vec3<float> normal;
+            float depth;
+            if (simplex.count < 4 || !epa(shape, simplex, normal, depth)) {
+                // touching in a single point or an edge
+                normal = normalized_or(position_b - position_a, Vec3<float>{ 0.0f, 1.0f, 0.0f });
+                depth = 0.0f;
+            }
+            manifold.normal = normal;
+            manifold.depth = depth + radius;
+        }
+
+        // bodies don't rotate, any point between the shapes does
+        manifold.point = (position_a + a.support(manifold.normal) + position_b + b.support(manifold.normal * -1.0f)) * 0.5f;
+        return true;
+    }
+
+    // a.type <= b.type
+    bool collide_sorted(const Collider& a, const Vec3<float>& position_a, const Collider& b, const Vec3<float>& position_b, ContactManifold& manifold, float margin) {
+        using Type = Collider::Type;
+
+        // segment against a box has no short closed form, gjk on the cores is exact
+        if (a.type == Type::CONVEX_HULL || b.type == Type::CONVEX_HULL || (a.type == Type::CAPSULE && b.type == Type::BOX)) {
+            return hulls(a, position_a, b, position_b, manifold, margin);
+        }
+
+        const Vec3<float> center_a{ position_a + a.center };
+        const Vec3<float> center_b{ position_b + b.center };
+
+        switch (a.type) {
+            case Type::SPHERE:
+                switch (b.type) {
+                    case Type::SPHERE:
+                        return spheres(center_a, a.radius, center_b, b.radius, manifold, margin);
+                    case Type::CAPSULE: {
+                        const Vec3<float> on_b{ closest_on_segment(center_a, center_b - b.axis * b.half_height, center_b + b.axis * b.half_height) };
+                        return spheres(center_a, a.radius, on_b, b.radius, manifold, margin);
+                    }
+                    default:
+                        return sphere_box(center_a, a.radius, world_box(b, position_b), manifold, margin);
+                }
+            case Type::CAPSULE:
+            {
+                Vec3<float> on_a;
+                Vec3<float> on_b;
+                closest_between_segments(
+                    center_a - a.axis * a.half_height, center_a + a.axis * a.half_height,
+                    center_b - b.axis * b.half_height, center_b + b.axis * b.half_height,
+                    on_a, on_b
+                );
+                return spheres(on_a, a.radius, on_b, b.radius, manifold, margin);
+            }
+            default:
+                return my_gl::collide_aabb(world_box(a, position_a), world_box(b, position_b), manifold, margin);
+        }
+    }
+}
+
+my_gl::Collider my_gl::Collider::sphere(float radius, const math::Vec3<float>& center) {
+    return Collider{ .type = Type::SPHERE, .center = center, .radius = radius };
+}
+
+my_gl::Collider my_gl::Collider::capsule(float radius, float half_height, const math::Vec3<float>& axis, const math::Vec3<float>& center) {
+    return Collider{
+        .type = Type::CAPSULE,
+        .center = center,
+        .radius = radius,
+        .axis = normalized_or(axis, math::Vec3<float>{ 0.0f, 1.0f, 0.0f }),
+        .half_height = half_height,
+    };
+}
+
+my_gl::Collider my_gl::Collider::box(const math::Vec3<float>& half_extents, const math::Vec3<float>& center) {
+    return Collider{ .type = Type::BOX, .center = center, .half_extents = half_extents };
+}
+
+my_gl::Collider my_gl::Collider::box(const AABB& bounds) {
+    return box((bounds.max - bounds.min) * 0.5f, bounds.center());
+}
+
+my_gl::Collider my_gl::Collider::convex_hull(std::span<const math::Vec3<float>> points, const math::Vec3<float>& center) {
+    return Collider{ .type = Type::CONVEX_HULL, .center = center, .hull_points = points };
+}
+
+my_gl::AABB my_gl::Collider::local_bounds() const {
+    AABB res;
+
+    switch (type) {
+        case Type::SPHERE:
+            res.min = center - radius;
+            res.max = center + radius;
+            break;
+        case Type::CAPSULE: {
+            const math::Vec3<float> ends[2]{ center - axis * half_height, center + axis * half_height };
+            for (const math::Vec3<float>& end : ends) {
+                res.expand(end - radius);
+                res.expand(end + radius);
+            }
+            break;
+        }
+        case Type::BOX:
+            // empty box stays empty
+            if (half_extents[0] >= 0.0f) {
+                res.min = center - half_extents;
+                res.max = center + half_extents;
+            }
+            break;
+        case Type::CONVEX_HULL:
+            for (const math::Vec3<float>& point : hull_points) {
+                res.expand(center + point);
+            }
+            break;
+    }
+
+    return res;
+}
+
+my_gl::math::Vec3<float> my_gl::Collider::support(const math::Vec3<float>& direction) const {
+    switch (type) {
+        case Type::SPHERE:
+            return center + normalized_or(direction, math::Vec3<float>{ 1.0f, 0.0f, 0.0f }) * radius;
+        case Type::CAPSULE: {
+            const float side{ axis.dot(direction) >= 0.0f ? 1.0f : -1.0f };
+            return center + axis * (half_height * side) + normalized_or(direction, math::Vec3<float>{ 1.0f, 0.0f, 0.0f }) * radius;
+        }
+        case Type::BOX:
+            return center + math::Vec3<float>{
+                direction[0] >= 0.0f ? half_extents[0] : -half_extents[0],
+                direction[1] >= 0.0f ? half_extents[1] : -half_extents[1],
+                direction[2] >= 0.0f ? half_extents[2] : -half_extents[2],
+            };
+        case Type::CONVEX_HULL: {
+            if (hull_points.empty()) {
+                return center;
+            }
+            const math::Vec3<float>* best{ &hull_points[0] };
+            float best_dot{ best->dot(direction) };
+            for (const math::Vec3<float>& point : hull_points) {
+                const float point_dot{ point.dot(direction) };
+                if (point_dot > best_dot) {
+                    best_dot = point_dot;
+                    best = &point;
+                }
+            }
+            return center + *best;
+        }
+    }
+    return center;
+}
+
+bool my_gl::collide(
+    const Collider&             a,
+    const math::Vec3<float>&    position_a,
+    const Collider&             b,
+    const math::Vec3<float>&    position_b,
+    ContactManifold&            manifold,
+    float                       margin
+)
+{
+    // specialized tests only exist for one order of every pair
+    if (a.type <= b.type) {
+        return collide_sorted(a, position_a, b, position_b, manifold, margin);
+    }
+
+    if (!collide_sorted(b, position_b, a, position_a, manifold, margin)) {
+        return false;
+    }
+    manifold.normal = manifold.normal * -1.0f;
+    return true;
+}
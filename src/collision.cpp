@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "collision.hpp"
+
+my_gl::AABB my_gl::AABB::from_boundaries(const meshes::Boundaries& boundaries) {
+    AABB res;
+    for (const auto* corner : { &boundaries.ltn, &boundaries.ltf, &boundaries.rtn, &boundaries.rtf,
+                                &boundaries.lbn, &boundaries.lbf, &boundaries.rbn, &boundaries.rbf }) {
+        res.expand(*corner);
+    }
+    return res;
+}
+
+void my_gl::AABB::expand(const math::Vec3<float>& point) {
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        min[axis] = std::min(min[axis], point[axis]);
+        max[axis] = std::max(max[axis], point[axis]);
+    }
+}
+
+bool my_gl::AABB::overlaps(const AABB& rhs) const {
+    return min[0] <= rhs.max[0] && max[0] >= rhs.min[0]
+        && min[1] <= rhs.max[1] && max[1] >= rhs.min[1]
+        && min[2] <= rhs.max[2] && max[2] >= rhs.min[2];
+}
+
+bool my_gl::collide_aabb(const AABB& a, const AABB& b, ContactManifold& manifold, float margin) {
+    float min_overlap{ std::numeric_limits<float>::max() };
+    uint32_t min_axis{ 0 };
+
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        const float overlap{ std::min(a.max[axis], b.max[axis]) - std::max(a.min[axis], b.min[axis]) };
+        if (overlap <= -margin) {
+            return false;
+        }
+        if (overlap < min_overlap) {
+            min_overlap = overlap;
+            min_axis = axis;
+        }
+    }
+
+    // push out along the axis of the smallest penetration (or the biggest gap)
+    manifold.normal = math::Vec3<float>{ 0.0f, 0.0f, 0.0f };
+    manifold.normal[min_axis] = a.center()[min_axis] <= b.center()[min_axis] ? 1.0f : -1.0f;
+    manifold.depth = min_overlap;
+
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        manifold.point[axis] = (std::max(a.min[axis], b.min[axis]) + std::min(a.max[axis], b.max[axis])) * 0.5f;
+    }
+
+    return true;
+}
+
+bool my_gl::sweep_aabb(const AABB& a, const AABB& b, const math::Vec3<float>& motion, ContactManifold& manifold) {
+    float enter{ std::numeric_limits<float>::lowest() };
+    float exit{ 1.0f };
+    uint32_t enter_axis{ 3 };
+
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        if (motion[axis] == 0.0f) {
+            // not moving on this axis, must overlap all the time
+            if (b.max[axis] <= a.min[axis] || b.min[axis] >= a.max[axis]) {
+                return false;
+            }
+            continue;
+        }
+
+        const float inv_motion{ 1.0f / motion[axis] };
+        float axis_enter{ (a.min[axis] - b.max[axis]) * inv_motion };
+        float axis_exit{ (a.max[axis] - b.min[axis]) * inv_motion };
+        if (axis_enter > axis_exit) {
+            std::swap(axis_enter, axis_exit);
+        }
+        if (axis_enter > enter) {
+            enter = axis_enter;
+            enter_axis = axis;
+        }
+        exit = std::min(exit, axis_exit);
+        if (enter > exit) {
+            return false;
+        }
+    }
+
+    // already overlapping at the start is handled by collide_aabb
+    if (enter_axis == 3 || enter < 0.0f || enter > 1.0f) {
+        return false;
+    }
+
+    // b hits the face of a it moves toward
+    manifold.normal = math::Vec3<float>{ 0.0f, 0.0f, 0.0f };
+    manifold.normal[enter_axis] = motion[enter_axis] > 0.0f ? -1.0f : 1.0f;
+    manifold.depth = -enter * std::abs(motion[enter_axis]);
+
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        const float offset{ motion[axis] * enter };
+        manifold.point[axis] = (std::max(a.min[axis], b.min[axis] + offset) + std::min(a.max[axis], b.max[axis] + offset)) * 0.5f;
+    }
+
+    return true;
+}
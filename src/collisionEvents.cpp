@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <bit>
+#include <utility>
+#include "collisionEvents.hpp"
+
+my_gl::CollisionEventQueue::CollisionEventQueue(std::size_t capacity)
+    : _events(std::bit_ceil(std::max(capacity, std::size_t{ 1 })))
+{}
+
+void my_gl::CollisionEventQueue::push(const CollisionEvent& event) {
+    const std::size_t mask{ _events.size() - 1 };
+
+    if (_size == _events.size()) {
+        // full, drop the oldest one
+        _head = (_head + 1) & mask;
+        --_size;
+        ++_overwritten;
+    }
+
+    _events[(_head + _size) & mask] = event;
+    ++_size;
+}
+
+bool my_gl::CollisionEventQueue::pop(CollisionEvent& event) {
+    if (_size == 0) {
+        return false;
+    }
+
+    event = _events[_head];
+    _head = (_head + 1) & (_events.size() - 1);
+    --_size;
+    return true;
+}
+
+void my_gl::CollisionEventQueue::clear() {
+    _head = 0;
+    _size = 0;
+}
+
+void my_gl::CollisionEventQueue::reserve(std::size_t capacity) {
+    if (capacity <= _events.size()) {
+        return;
+    }
+
+    std::vector<CollisionEvent> events(std::bit_ceil(capacity));
+    const std::size_t mask{ _events.size() - 1 };
+    for (std::size_t i = 0; i < _size; ++i) {
+        events[i] = _events[(_head + i) & mask];
+    }
+    _events = std::move(events);
+    _head = 0;
+}
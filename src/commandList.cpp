@@ -0,0 +1,89 @@
+#include <cassert>
+#include "commandList.hpp"
+#include "glState.hpp"
+#include "renderer.hpp"
+#include "texture.hpp"
+#include "uniformBuffer.hpp"
+
+namespace {
+    // arena bytes aren't aligned for the command, so it is copied out
+    template<typename T>
+    T read(const std::byte* payload) {
+        T command;
+        std::memcpy(&command, payload, sizeof(T));
+        return command;
+    }
+}
+
+void my_gl::CommandList::replay() const {
+    std::size_t offset{ 0 };
+    while (offset < _arena.size()) {
+        const Header header{ read<Header>(_arena.data() + offset) };
+        const std::byte* payload{ _arena.data() + offset + HEADER_BYTE_SIZE };
+
+        switch (header.type) {
+        case commands::USE_PROGRAM:
+            read<commands::UseProgram>(payload).program->use();
+            break;
+        case commands::BIND_VERTEX_ARRAY: {
+            const VertexArray* vao{ read<commands::BindVertexArray>(payload).vao };
+            vao->bind();
+            if (vao->is_dynamic()) {
+                vao->stream_vertices();
+            }
+            break;
+        }
+        case commands::BIND_TEXTURE:
+            read<commands::BindTexture>(payload).texture->bind();
+            break;
+        case commands::SET_TRANSPARENT: {
+            const bool is_transparent{ read<commands::SetTransparent>(payload).is_transparent };
+            globals::gl_state.set_enabled(GL_BLEND, is_transparent);
+            if (is_transparent) {
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            }
+            glDepthMask(is_transparent ? GL_FALSE : GL_TRUE);
+            break;
+        }
+        case commands::BIND_OBJECT_DATA: {
+            const auto command{ read<commands::BindObjectData>(payload) };
+            globals::gl_state.bind_buffer_range(
+                GL_UNIFORM_BUFFER, UniformBlock::OBJECT_DATA, command.buffer_id, command.byte_offset, sizeof(ObjectDataStd140)
+            );
+            break;
+        }
+        case commands::ATTACH_INSTANCES: {
+            const auto command{ read<commands::AttachInstances>(payload) };
+            command.vao->attach_instances(command.buffer_id, command.byte_offset);
+            break;
+        }
+        case commands::DRAW_ELEMENTS: {
+            const auto command{ read<commands::DrawElements>(payload) };
+            const void* indices{ reinterpret_cast<const void*>(command.index_byte_offset) };
+            if (command.instance_count == 0) {
+                glDrawElements(command.mode, command.count, GL_UNSIGNED_SHORT, indices);
+            }
+            else {
+                glDrawElementsInstanced(command.mode, command.count, GL_UNSIGNED_SHORT, indices, command.instance_count);
+            }
+            break;
+        }
+        case commands::MULTI_DRAW_ELEMENTS_INDIRECT: {
+            const auto command{ read<commands::MultiDrawElementsIndirect>(payload) };
+            globals::gl_state.bind_buffer(GL_DRAW_INDIRECT_BUFFER, command.buffer_id);
+            glMultiDrawElementsIndirect(
+                command.mode,
+                GL_UNSIGNED_SHORT,
+                reinterpret_cast<const void*>(command.commands_byte_offset),
+                command.draw_count,
+                0
+            );
+            break;
+        }
+        default:
+            assert(false && "unknown command in the list");
+        }
+
+        offset += HEADER_BYTE_SIZE + header.byte_size;
+    }
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cmath>
+#include "contactSolver.hpp"
+
+namespace {
+    using my_gl::math::Vec3;
+
+    Vec3<float> get_vec(const my_gl::SoAVec3& axes, my_gl::BodyId body) {
+        return { axes[0][body], axes[1][body], axes[2][body] };
+    }
+
+    // impulse acts on b, opposite one on a
+    void apply_impulse(
+        my_gl::SoAVec3&             velocity,
+        const std::vector<float>&   inv_mass,
+        my_gl::BodyId               body_a,
+        my_gl::BodyId               body_b,
+        const Vec3<float>&          impulse
+    )
+    {
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            velocity[axis][body_a] -= impulse[axis] * inv_mass[body_a];
+            velocity[axis][body_b] += impulse[axis] * inv_mass[body_b];
+        }
+    }
+
+    // same normal always gives the same tangents, so cached friction impulses stay valid
+    void tangent_basis(const Vec3<float>& normal, Vec3<float>& tangent_0, Vec3<float>& tangent_1) {
+        if (std::abs(normal[0]) >= 0.57735f) {
+            tangent_0 = Vec3<float>{ normal[1], -normal[0], 0.0f }.normalize_inplace();
+        }
+        else {
+            tangent_0 = Vec3<float>{ 0.0f, normal[2], -normal[1] }.normalize_inplace();
+        }
+        tangent_1 = normal.cross(tangent_0);
+    }
+}
+
+void my_gl::ContactSolver::solve(
+    std::span<ContactManifold>  manifolds,
+    SoAVec3&                    velocity,
+    const std::vector<float>&   inv_mass,
+    const std::vector<float>&   friction,
+    const std::vector<float>&   restitution,
+    float                       step_duration
+)
+{
+    warm_start(manifolds);
+    _constraints.resize(manifolds.size());
+
+    const float inv_step_duration{ 1.0f / step_duration };
+
+    // prepare constraints with velocities before any impulse
+    for (std::size_t i = 0; i < manifolds.size(); ++i) {
+        ContactManifold& manifold{ manifolds[i] };
+        ConstraintData& constraint{ _constraints[i] };
+        const BodyId a{ manifold.body_a };
+        const BodyId b{ manifold.body_b };
+
+        const float inv_mass_sum{ inv_mass[a] + inv_mass[b] };
+        if (inv_mass_sum == 0.0f) {
+            constraint.mass = 0.0f;
+            continue;
+        }
+
+        constraint.mass = 1.0f / inv_mass_sum;
+        constraint.friction = std::sqrt(friction[a] * friction[b]);
+        tangent_basis(manifold.normal, constraint.tangent[0], constraint.tangent[1]);
+
+        // speculative contact lets the gap close, but not more;
+        // penetrating one is pushed out by a fraction of the depth
+        const float normal_vel{ (get_vec(velocity, b) - get_vec(velocity, a)).dot(manifold.normal) };
+        float bias{ manifold.depth < 0.0f
+            ? manifold.depth * inv_step_duration
+            : _settings.baumgarte * inv_step_duration * std::max(manifold.depth - _settings.penetration_slop, 0.0f)
+        };
+        // bounce only if bodies actually touch during this step
+        if (normal_vel < -_settings.restitution_threshold && manifold.depth - normal_vel * step_duration >= 0.0f) {
+            bias = std::max(bias, -std::max(restitution[a], restitution[b]) * normal_vel);
+        }
+        constraint.bias = bias;
+    }
+
+    // warm starting goes after all biases are known,
+    // otherwise impulses of neighbours would look like an impact
+    for (std::size_t i = 0; i < manifolds.size(); ++i) {
+        const ContactManifold& manifold{ manifolds[i] };
+        const ConstraintData& constraint{ _constraints[i] };
+        if (constraint.mass == 0.0f) {
+            continue;
+        }
+
+        Vec3<float> warm_impulse{
+            manifold.normal * manifold.normal_impulse
+            + constraint.tangent[0] * manifold.tangent_impulse[0]
+            + constraint.tangent[1] * manifold.tangent_impulse[1]
+        };
+        apply_impulse(velocity, inv_mass, manifold.body_a, manifold.body_b, warm_impulse);
+    }
+
+    for (uint32_t iteration = 0; iteration < _settings.iterations; ++iteration) {
+        for (std::size_t i = 0; i < manifolds.size(); ++i) {
+            ContactManifold& manifold{ manifolds[i] };
+            const ConstraintData& constraint{ _constraints[i] };
+            if (constraint.mass == 0.0f) {
+                continue;
+            }
+            const BodyId a{ manifold.body_a };
+            const BodyId b{ manifold.body_b };
+
+            // friction, bounded by the current normal impulse
+            const float max_friction{ constraint.friction * manifold.normal_impulse };
+            for (uint32_t t = 0; t < 2; ++t) {
+                const float tangent_vel{ (get_vec(velocity, b) - get_vec(velocity, a)).dot(constraint.tangent[t]) };
+                const float old_impulse{ manifold.tangent_impulse[t] };
+                manifold.tangent_impulse[t] = std::clamp(old_impulse - tangent_vel * constraint.mass, -max_friction, max_friction);
+                apply_impulse(velocity, inv_mass, a, b, constraint.tangent[t] * (manifold.tangent_impulse[t] - old_impulse));
+            }
+
+            // normal, can only push
+            const float normal_vel{ (get_vec(velocity, b) - get_vec(velocity, a)).dot(manifold.normal) };
+            const float old_impulse{ manifold.normal_impulse };
+            manifold.normal_impulse = std::max(old_impulse + (constraint.bias - normal_vel) * constraint.mass, 0.0f);
+            apply_impulse(velocity, inv_mass, a, b, manifold.normal * (manifold.normal_impulse - old_impulse));
+        }
+    }
+
+    store_impulses(manifolds);
+}
+
+void my_gl::ContactSolver::warm_start(std::span<ContactManifold> manifolds) {
+    // both sequences are sorted by key
+    std::size_t cached{ 0 };
+    for (ContactManifold& manifold : manifolds) {
+        while (cached < _cache.size() && _cache[cached].key < manifold.key) {
+            ++cached;
+        }
+
+        // a contact which flipped to another face starts from zero
+        if (cached < _cache.size() && _cache[cached].key == manifold.key && _cache[cached].normal.dot(manifold.normal) > 0.95f) {
+            manifold.normal_impulse = _cache[cached].normal_impulse;
+            manifold.tangent_impulse[0] = _cache[cached].tangent_impulse[0];
+            manifold.tangent_impulse[1] = _cache[cached].tangent_impulse[1];
+        }
+        else {
+            manifold.normal_impulse = 0.0f;
+            manifold.tangent_impulse[0] = 0.0f;
+            manifold.tangent_impulse[1] = 0.0f;
+        }
+    }
+}
+
+void my_gl::ContactSolver::store_impulses(std::span<const ContactManifold> manifolds) {
+    _cache.clear();
+    for (const ContactManifold& manifold : manifolds) {
+        _cache.push_back(CachedImpulse{
+            .key = manifold.key,
+            .normal = manifold.normal,
+            .normal_impulse = manifold.normal_impulse,
+            .tangent_impulse = { manifold.tangent_impulse[0], manifold.tangent_impulse[1] },
+        });
+    }
+}
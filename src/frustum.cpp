@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "frustum.hpp"
+#include "simd.hpp"
+
+void my_gl::BoundingSpheres::resize(std::size_t count) {
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    radius.resize(count);
+}
+
+void my_gl::BoundingSpheres::set(std::size_t index, const BoundingSphere& sphere) {
+    x[index] = sphere.center[0];
+    y[index] = sphere.center[1];
+    z[index] = sphere.center[2];
+    // no bounds, a sphere big enough to be in front of every plane
+    radius[index] = sphere.radius < 0.0f ? std::numeric_limits<float>::max() : sphere.radius;
+}
+
+// gribb-hartmann, clip space -w <= x, y, z <= w written as planes over world coords,
+// the matrix is row major, so the planes are sums of its rows
+my_gl::Frustum my_gl::Frustum::from_view_proj(const math::Matrix44<float>& view_proj_mat) {
+    Frustum frustum;
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+        for (std::size_t side = 0; side < 2; ++side) {
+            const float sign{ side == 0 ? 1.0f : -1.0f };
+            std::array<float, 4>& plane{ frustum.planes[axis * 2 + side] };
+            for (std::size_t col = 0; col < 4; ++col) {
+                plane[col] = view_proj_mat.at(3, col) + sign * view_proj_mat.at(axis, col);
+            }
+
+            const float length{ std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]) };
+            for (float& val : plane) {
+                val /= length;
+            }
+        }
+    }
+    return frustum;
+}
+
+std::size_t my_gl::Frustum::cull(const BoundingSpheres& spheres, std::vector<uint8_t>& visible) const {
+    using simd::F32x4;
+
+    const std::size_t count{ spheres.size() };
+    visible.resize(count);
+    std::size_t visible_count{ 0 };
+
+    const auto test_plane{ [](const std::array<float, 4>& plane, F32x4 x, F32x4 y, F32x4 z, F32x4 radius) {
+        // signed distance of the sphere surface point nearest to the inside
+        return F32x4::broadcast(plane[0]) * x + F32x4::broadcast(plane[1]) * y + F32x4::broadcast(plane[2]) * z
+            + F32x4::broadcast(plane[3]) + radius;
+    } };
+
+    std::size_t i{ 0 };
+    for (; i + F32x4::width <= count; i += F32x4::width) {
+        const F32x4 x{ F32x4::load(&spheres.x[i]) };
+        const F32x4 y{ F32x4::load(&spheres.y[i]) };
+        const F32x4 z{ F32x4::load(&spheres.z[i]) };
+        const F32x4 radius{ F32x4::load(&spheres.radius[i]) };
+
+        F32x4 nearest{ test_plane(planes[0], x, y, z, radius) };
+        for (std::size_t plane = 1; plane < planes.size(); ++plane) {
+            nearest = F32x4::min(nearest, test_plane(planes[plane], x, y, z, radius));
+        }
+
+        float distances[F32x4::width];
+        nearest.store(distances);
+        for (std::size_t lane = 0; lane < F32x4::width; ++lane) {
+            visible[i + lane] = distances[lane] >= 0.0f;
+            visible_count += visible[i + lane];
+        }
+    }
+
+    // tail, fewer than 4 left
+    for (; i < count; ++i) {
+        float nearest{ std::numeric_limits<float>::max() };
+        for (const auto& plane : planes) {
+            nearest = std::min(nearest, plane[0] * spheres.x[i] + plane[1] * spheres.y[i] + plane[2] * spheres.z[i] + plane[3] + spheres.radius[i]);
+        }
+        visible[i] = nearest >= 0.0f;
+        visible_count += visible[i];
+    }
+
+    return visible_count;
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <span>
 #include "geometryObject.hpp"
@@ -5,6 +7,7 @@
 #include "matrix.hpp"
 #include "meshes.hpp"
 #include "renderer.hpp"
+#include "replay.hpp"
 #include "sharedTypes.hpp"
 #ifdef DEBUG
 #include <iostream>
@@ -30,47 +33,83 @@ my_gl::GeometryObjectPrimitive::GeometryObjectPrimitive(
     GLenum                              draw_type,
     Material::Type                      material_type,
     const Texture* const                texture,
-    my_gl::math::Vec3<float>&&          change_collision_vec,
     bool                                is_static
 )
     : _transform_data{ transform_data }
-    , _change_collision_vec{ std::move(change_collision_vec) }
     , _physics{ physics }
     , _texture{ texture }
     , _program{ program }
     , _vao{ vao }
     , _vertices_count{ vertices_count }
     , _buffer_byte_offset{ buffer_byte_offset }
+    , _local_bounds{ .center = { 0.0f, 0.0f, 0.0f }, .radius = -1.0f }
     , _draw_type{ draw_type }
     , _material_type{ material_type }
     , _is_static{ is_static }
-{}
+{
+    if (_vao._mesh.boundaries) {
+        const AABB bounds{ AABB::from_boundaries(*_vao._mesh.boundaries) };
+        _local_bounds.center = bounds.center();
+        _local_bounds.radius = math::Vec3<float>(bounds.max - _local_bounds.center).length();
+    }
+}
+
+void my_gl::GeometryObjectPrimitive::register_physics(PhysicsWorld& world) {
+    if (!_physics) {
+        return;
+    }
+
+    _physics->_body = world.add_body(
+        _physics->_start_val,
+        _physics->_velocity,
+        _physics->_acceleration,
+        _is_static ? 0.0f : _physics->_mass,
+        _physics->_restitution,
+        _physics->_friction
+    );
+    world.set_ccd(_physics->_body, _physics->_ccd);
+
+    if (_physics->_collider) {
+        world.set_collider(_physics->_body, *_physics->_collider);
+    }
+    else if (_vao._mesh.boundaries) {
+        // bounds with the body at the origin, world adds body position to them
+        update_anims();
+        const math::Matrix44<float> local_model_mat{ calc_model_mat({ 0.0f, 0.0f, 0.0f }) };
+        world.set_local_bounds(_physics->_body, AABB::from_boundaries(_vao._mesh.transform_boundaries(local_model_mat)));
+    }
+}
+
+void my_gl::GeometryObjectPrimitive::update_anims() {
+    for (my_gl::TransformData& transforms_by_type : _transform_data) {
+        for (my_gl::Animation<float>& animation : transforms_by_type.anims) {
+            animation.update();
+        }
+    }
+}
 
-void my_gl::GeometryObjectPrimitive::calc_model_mat_frame(Duration_sec frame_time) {
+my_gl::math::Matrix44<float> my_gl::GeometryObjectPrimitive::calc_model_mat(const math::Vec3<float>& physics_pos) const {
     auto result_mat{ my_gl::math::Matrix44<float>::identity_new() };
 
-    if (_transform_data.size()) {
-        for (my_gl::TransformData& transforms_by_type : _transform_data) {
-            if (transforms_by_type.type == math::TransformationType::TRANSLATION && _physics && !_is_static) {
-                for (const auto& transform : transforms_by_type.transforms) {
-                    result_mat *= transform;
-                }
-                result_mat *= _physics->update(frame_time.count());
-                for (my_gl::Animation<float>& animation : transforms_by_type.anims) {
-                    result_mat *= animation.update();
-                }
-            } else {
-                for (const auto& transform : transforms_by_type.transforms) {
-                    result_mat *= transform;
-                }
-                for (my_gl::Animation<float>& animation : transforms_by_type.anims) {
-                    result_mat *= animation.update();
-                }
-            }
+    for (const my_gl::TransformData& transforms_by_type : _transform_data) {
+        for (const auto& transform : transforms_by_type.transforms) {
+            result_mat *= transform;
+        }
+        if (transforms_by_type.type == math::TransformationType::TRANSLATION && _physics) {
+            result_mat *= math::Matrix44<float>::translation(physics_pos);
+        }
+        for (const my_gl::Animation<float>& animation : transforms_by_type.anims) {
+            result_mat *= animation._mat;
         }
     }
 
-    _model_mat = std::move(result_mat);
+    return result_mat;
+}
+
+void my_gl::GeometryObjectPrimitive::calc_model_mat_frame(const PhysicsWorld& world, float physics_alpha) {
+    _model_mat = calc_model_mat(
+        _physics ? world.interpolated_position(_physics->_body, physics_alpha) : math::Vec3<float>{ 0.0f, 0.0f, 0.0f }
+    );
 }
 
 void my_gl::GeometryObjectPrimitive::update_anims_time(Duration_sec frame_time) {
@@ -81,109 +120,81 @@ void my_gl::GeometryObjectPrimitive::update_anims_time(Duration_sec frame_time)
     }
 }
 
-void my_gl::GeometryObjectPrimitive::bind_state() const {
-    if (_texture) {
-        _texture->bind();
+my_gl::BoundingSphere my_gl::GeometryObjectPrimitive::world_bounds() const {
+    if (_local_bounds.radius < 0.0f) {
+        return _local_bounds;
     }
-    _program.use();
-    _vao.bind();
-}
 
-void my_gl::GeometryObjectPrimitive::un_bind_state() const {
-    if (_texture) {
-        _texture->un_bind();
+    // radius grows with the largest scale of the model matrix
+    float max_scale_sq{ 0.0f };
+    for (std::size_t col = 0; col < 3; ++col) {
+        float scale_sq{ 0.0f };
+        for (std::size_t row = 0; row < 3; ++row) {
+            scale_sq += _model_mat.at(row, col) * _model_mat.at(row, col);
+        }
+        max_scale_sq = std::max(max_scale_sq, scale_sq);
     }
-    _program.un_use();
-    _vao.un_bind();
+
+    const math::Vec4<float> center{ _model_mat * math::Vec4<float>(_local_bounds.center) };
+    return BoundingSphere{
+        .center = { center[0], center[1], center[2] },
+        .radius = _local_bounds.radius * std::sqrt(max_scale_sq),
+    };
 }
 
-void my_gl::GeometryObjectPrimitive::draw() const {
-    glDrawElements(
-        _draw_type,
-        _vertices_count,
-        GL_UNSIGNED_SHORT,
-        reinterpret_cast<const void*>(_buffer_byte_offset)
-    );
+void my_gl::GeometryObjectPrimitive::emit(RenderQueue& queue, const my_gl::math::Matrix44<float>& view_mat) const {
+    // view space z of the model origin, camera looks down -z
+    float view_z{ view_mat.at(2, 3) };
+    for (std::size_t col = 0; col < 3; ++col) {
+        view_z += view_mat.at(2, col) * _model_mat.at(col, 3);
+    }
+    queue.push(*this, -view_z);
 }
 
-void my_gl::GeometryObjectPrimitive::render(
+my_gl::ObjectDataStd140 my_gl::GeometryObjectPrimitive::object_data(
     const my_gl::math::Matrix44<float>& view_mat,
-    const my_gl::math::Matrix44<float>& view_proj_mat,
-    Duration_sec frame_time,
-    float time_0to1
-)
+    const my_gl::math::Matrix44<float>& view_proj_mat
+) const
 {
-    bind_state();
-
-    this->calc_model_mat_frame(frame_time);
     my_gl::math::Matrix44<float> model_view_mat{ view_mat * _model_mat };
     my_gl::math::Matrix44<float> normal_mat{ model_view_mat.invert().transpose() };
     my_gl::math::Matrix44<float> mvp_mat{ view_proj_mat * _model_mat };
 
-    _program.set_uniform_value("u_model_view_mat", model_view_mat.data());
-    _program.set_uniform_value("u_normal_mat", normal_mat.data());
-    _program.set_uniform_value("u_mvp_mat", mvp_mat.data());
-    // _program.set_uniform_value("u_lerp", time_0to1);
-
-    if (_material_type != Material::NO_MATERIAL) {
-        const my_gl::Material& material = my_gl::Material::get_from_table(_material_type);
-        _program.set_uniform_value("u_material.ambient", material.ambient);
-        _program.set_uniform_value("u_material.diffuse", material.diffuse);
-        _program.set_uniform_value("u_material.specular", material.specular);
-        _program.set_uniform_value("u_material.shininess", material.shininess);
-    }
+    // the block is row major, like the matrices
+    ObjectDataStd140 object_data{};
+    std::copy_n(model_view_mat.data(), 16, object_data.model_view_mat.begin());
+    std::copy_n(normal_mat.data(), 16, object_data.normal_mat.begin());
+    std::copy_n(mvp_mat.data(), 16, object_data.mvp_mat.begin());
+    object_data.material_index = _material_type != Material::NO_MATERIAL ? _material_type : 0;
 
-    draw();
-    un_bind_state();
+    return object_data;
 }
 
-bool my_gl::GeometryObjectPrimitive::check_collision(GeometryObjectPrimitive& second) {
-    if (this == &second) {
-        return false;
+my_gl::InstanceData my_gl::GeometryObjectPrimitive::instance_data() const {
+    InstanceData instance;
+    const float* model_mat{ _model_mat.data() };
+    for (std::size_t row = 0; row < 4; ++row) {
+        for (std::size_t col = 0; col < 4; ++col) {
+            instance.model_mat[col * 4 + row] = model_mat[row * 4 + col];
+        }
     }
+    // material table has no entry for NO_MATERIAL
+    instance.material = _material_type != Material::NO_MATERIAL ? _material_type : 0;
 
-    meshes::Boundaries first_transformed_boundaries{ this->_vao._mesh.transform_boundaries(_model_mat) };
-    meshes::Boundaries second_transformed_boundaries{ second._vao._mesh.transform_boundaries(second._model_mat) };
-
-    // TODO: checking if the sides were reversed by rotations
-    // float first_left = first_transformed_boundaries.ltn[0] < first_transformed_boundaries.rtn[0]
-    //     ? first_transformed_boundaries.ltn[0] : first_transformed_boundaries.rtn[0];
-    // float first_top = first_transformed_boundaries.ltn[1] < first_transformed_boundaries.rtn[1]
-    //     ? first_transformed_boundaries.ltn[1] : first_transformed_boundaries.rtn[1];
-    // float first_near = first_transformed_boundaries.ltn[2] < first_transformed_boundaries.rtn[2]
-    //     ? first_transformed_boundaries.ltn[2] : first_transformed_boundaries.rtn[2];
-    //
-    // float second_left = second_transformed_boundaries.ltn[0] < second_transformed_boundaries.rtn[0]
-    //     ? second_transformed_boundaries.ltn[0] : second_transformed_boundaries.rtn[0];
-    // float second_top = second_transformed_boundaries.ltn[1] < second_transformed_boundaries.rtn[1]
-    //     ? second_transformed_boundaries.ltn[1] : second_transformed_boundaries.rtn[1];
-    // float second_near = second_transformed_boundaries.ltn[2] < second_transformed_boundaries.rtn[2]
-    //     ? second_transformed_boundaries.ltn[2] : second_transformed_boundaries.rtn[2];
-
-    // determine which object is left, top, near
-    meshes::Boundaries& left_object = first_transformed_boundaries.ltn[0] < second_transformed_boundaries.ltn[0] ? first_transformed_boundaries : second_transformed_boundaries;
-    meshes::Boundaries& right_object = first_transformed_boundaries.ltn[0] > second_transformed_boundaries.ltn[0] ? first_transformed_boundaries : second_transformed_boundaries;
-    meshes::Boundaries& top_object = first_transformed_boundaries.ltn[1] > second_transformed_boundaries.ltn[1] ? first_transformed_boundaries : second_transformed_boundaries;
-    meshes::Boundaries& bottom_object = first_transformed_boundaries.ltn[1] < second_transformed_boundaries.ltn[1] ? first_transformed_boundaries : second_transformed_boundaries;
-    meshes::Boundaries& near_object = first_transformed_boundaries.ltn[2] < second_transformed_boundaries.ltn[2] ? first_transformed_boundaries : second_transformed_boundaries;
-    meshes::Boundaries& far_object = first_transformed_boundaries.ltn[2] > second_transformed_boundaries.ltn[2] ? first_transformed_boundaries : second_transformed_boundaries;
-
-    return left_object.rtn[0] >= right_object.ltn[0] && bottom_object.rtn[1] >= top_object.rbn[1] && near_object.ltf[2] >= far_object.ltn[2];
-}
-
-void my_gl::GeometryObjectPrimitive::handle_collision(my_gl::GeometryObjectPrimitive& second) {
-    if (!_physics || !second._physics) {
-        return;
-    }
+    return instance;
+}
 
-    if (!this->_is_static) {
-        this->_physics->_velocity *= second._change_collision_vec * second._physics->_mass / this->_physics->_mass;
-        this->_physics->_acceleration *= -1.0f;
-    }
-    if (!second._is_static) {
-        second._physics->_velocity *= this->_change_collision_vec * this->_physics->_mass / second._physics->_mass;
-        second._physics->_acceleration *= -1.0f;
-    }
+my_gl::commands::DrawElements my_gl::GeometryObjectPrimitive::draw_command(uint32_t instance_count) const {
+    return commands::DrawElements{
+        .mode = _draw_type,
+        .count = static_cast<uint32_t>(_vertices_count),
+        .index_byte_offset = _buffer_byte_offset,
+        .instance_count = instance_count,
+    };
+}
+
+uint64_t my_gl::GeometryObjectPrimitive::hash_transforms(uint64_t hash) const {
+    return fnv1a(_model_mat.data(), sizeof(float) * 16, hash);
 }
 
 // GeometryObjectComplex
@@ -199,15 +210,10 @@ my_gl::GeometryObjectComplex::GeometryObjectComplex(
     : _primitives{ primitives }
 {}
 
-void my_gl::GeometryObjectComplex::render(
-    const my_gl::math::Matrix44<float>& view_mat,
-    const my_gl::math::Matrix44<float>& view_proj_mat,
-    Duration_sec frame_time,
-    float time_0to1
-)
+void my_gl::GeometryObjectComplex::register_physics(PhysicsWorld& world)
 {
     for (auto& primitive : _primitives) {
-        primitive.render(view_mat, view_proj_mat, frame_time, time_0to1);
+        primitive.register_physics(world);
     }
 }
 
@@ -218,6 +224,14 @@ void my_gl::GeometryObjectComplex::update_anims_time(my_gl::Duration_sec frame_t
     }
 }
 
+uint64_t my_gl::GeometryObjectComplex::hash_transforms(uint64_t hash) const
+{
+    for (const auto& primitive : _primitives) {
+        hash = primitive.hash_transforms(hash);
+    }
+    return hash;
+}
+
 // Material
 my_gl::Material::Material(
     my_gl::math::Vec3<float>&&      ambient_,
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include "glState.hpp"
+
+namespace {
+    template<std::size_t N>
+    std::size_t index_of(const std::array<GLenum, N>& values, GLenum value) {
+        return static_cast<std::size_t>(std::find(values.begin(), values.end(), value) - values.begin());
+    }
+}
+
+bool my_gl::GLStateCache::is_redundant(uint32_t& shadow, uint32_t value) {
+    if (shadow == value) {
+        ++_stats.elided;
+        return true;
+    }
+    shadow = value;
+    ++_stats.issued;
+    return false;
+}
+
+void my_gl::GLStateCache::use_program(uint32_t program_id) {
+    if (!is_redundant(_program, program_id)) {
+        glUseProgram(program_id);
+    }
+}
+
+void my_gl::GLStateCache::bind_vertex_array(uint32_t vao_id) {
+    if (!is_redundant(_vao, vao_id)) {
+        glBindVertexArray(vao_id);
+        _buffers[index_of(BUFFER_TARGETS, GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    }
+}
+
+void my_gl::GLStateCache::bind_buffer(GLenum target, uint32_t buffer_id) {
+    const std::size_t index{ index_of(BUFFER_TARGETS, target) };
+    if (index == BUFFER_TARGETS.size()) {
+        ++_stats.issued;
+        glBindBuffer(target, buffer_id);
+        return;
+    }
+
+    if (!is_redundant(_buffers[index], buffer_id)) {
+        glBindBuffer(target, buffer_id);
+    }
+}
+
+void my_gl::GLStateCache::bind_buffer_base(GLenum target, uint32_t index, uint32_t buffer_id) {
+    ++_stats.issued;
+    glBindBufferBase(target, index, buffer_id);
+
+    // it also binds the buffer to the generic binding point of the target
+    const std::size_t target_index{ index_of(BUFFER_TARGETS, target) };
+    if (target_index < BUFFER_TARGETS.size()) {
+        _buffers[target_index] = buffer_id;
+    }
+}
+
+void my_gl::GLStateCache::bind_buffer_range(GLenum target, uint32_t index, uint32_t buffer_id, std::size_t byte_offset, std::size_t byte_size) {
+    ++_stats.issued;
+    glBindBufferRange(target, index, buffer_id, static_cast<GLintptr>(byte_offset), static_cast<GLsizeiptr>(byte_size));
+
+    const std::size_t target_index{ index_of(BUFFER_TARGETS, target) };
+    if (target_index < BUFFER_TARGETS.size()) {
+        _buffers[target_index] = buffer_id;
+    }
+}
+
+void my_gl::GLStateCache::bind_texture(uint32_t unit, GLenum target, uint32_t texture_id) {
+    const std::size_t index{ index_of(TEXTURE_TARGETS, target) };
+    if (unit >= MAX_TEXTURE_UNITS || index == TEXTURE_TARGETS.size()) {
+        _active_unit = UNKNOWN;
+        _stats.issued += 2;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture_id);
+        return;
+    }
+
+    // unit only has to be switched when the binding changes
+    if (_textures[unit][index] == texture_id) {
+        ++_stats.elided;
+        return;
+    }
+    if (!is_redundant(_active_unit, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    is_redundant(_textures[unit][index], texture_id);
+    glBindTexture(target, texture_id);
+}
+
+void my_gl::GLStateCache::set_enabled(GLenum cap, bool enabled) {
+    const std::size_t index{ index_of(CAPS, cap) };
+    if (index < CAPS.size() && is_redundant(_caps[index], enabled)) {
+        return;
+    }
+    if (index == CAPS.size()) {
+        ++_stats.issued;
+    }
+
+    if (enabled) {
+        glEnable(cap);
+    }
+    else {
+        glDisable(cap);
+    }
+}
+
+void my_gl::GLStateCache::invalidate() {
+    _program = UNKNOWN;
+    _vao = UNKNOWN;
+    _active_unit = UNKNOWN;
+    _buffers.fill(UNKNOWN);
+    for (auto& unit_textures : _textures) {
+        unit_textures.fill(UNKNOWN);
+    }
+    _caps.fill(UNKNOWN);
+}
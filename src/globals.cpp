@@ -1,5 +1,6 @@
 #include "globals.hpp"
 #include "camera.hpp"
+#include "glState.hpp"
 
 namespace my_gl {
     namespace globals {
@@ -12,5 +13,8 @@ namespace my_gl {
             .diffuse = {0.5f, 0.5f, 0.5f},
             .specular = {1.0f, 1.0f, 1.0f},
         };
+
+        ReplayLog replay;
+        GLStateCache gl_state;
     }
 }
@@ -0,0 +1,75 @@
+#include <cassert>
+#include "gpuTimer.hpp"
+#include "profiler.hpp"
+
+my_gl::GpuTimer::GpuTimer() {
+    for (QuerySet& set : _sets) {
+        glGenQueries(static_cast<GLsizei>(set.queries.size()), set.queries.data());
+    }
+}
+
+my_gl::GpuTimer::~GpuTimer() {
+    for (QuerySet& set : _sets) {
+        glDeleteQueries(static_cast<GLsizei>(set.queries.size()), set.queries.data());
+    }
+}
+
+void my_gl::GpuTimer::begin_frame(Profiler& profiler) {
+    _set = (_set + 1) % FRAMES_IN_FLIGHT;
+    QuerySet& set{ _sets[_set] };
+    collect(set, profiler);
+
+    _is_recording = profiler._enabled;
+    set.frame_index = profiler.frame_index();
+    set.scope_count = 0;
+}
+
+uint32_t my_gl::GpuTimer::begin_scope(const char* name) {
+    QuerySet& set{ _sets[_set] };
+    if (!_is_recording || set.scope_count == SCOPES_MAX) {
+        return INVALID_SCOPE;
+    }
+
+    const uint32_t scope{ set.scope_count++ };
+    set.names[scope] = name;
+    glQueryCounter(set.queries[scope * 2], GL_TIMESTAMP);
+    return scope;
+}
+
+void my_gl::GpuTimer::end_scope(uint32_t scope) {
+    if (scope == INVALID_SCOPE) {
+        return;
+    }
+    assert(scope < _sets[_set].scope_count);
+
+    glQueryCounter(_sets[_set].queries[scope * 2 + 1], GL_TIMESTAMP);
+}
+
+void my_gl::GpuTimer::collect(QuerySet& set, Profiler& profiler) {
+    if (set.scope_count == 0) {
+        return;
+    }
+
+    // scopes may nest, so the last end query isn't necessarily the last one issued
+    GLint is_available{ 1 };
+    for (uint32_t i = 0; i < set.scope_count && is_available; ++i) {
+        glGetQueryObjectiv(set.queries[i * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &is_available);
+    }
+    if (is_available) {
+        GLuint64 frame_start_ns{ 0 };
+        glGetQueryObjectui64v(set.queries[0], GL_QUERY_RESULT, &frame_start_ns);
+        for (uint32_t i = 0; i < set.scope_count; ++i) {
+            GLuint64 start_ns{ 0 };
+            GLuint64 end_ns{ 0 };
+            glGetQueryObjectui64v(set.queries[i * 2], GL_QUERY_RESULT, &start_ns);
+            glGetQueryObjectui64v(set.queries[i * 2 + 1], GL_QUERY_RESULT, &end_ns);
+            profiler.add_gpu_sample(
+                set.frame_index,
+                set.names[i],
+                Duration_sec{ static_cast<float>(start_ns - frame_start_ns) * 1e-9f },
+                Duration_sec{ static_cast<float>(end_ns - start_ns) * 1e-9f }
+            );
+        }
+    }
+    set.scope_count = 0;
+}
@@ -0,0 +1,99 @@
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/glew.h>
+#include <cstdlib>
+#include <iostream>
+#include "headlessContext.hpp"
+#include "replay.hpp"
+#include "utils.hpp"
+
+namespace {
+    [[noreturn]] void fail(const char* what) {
+        std::cerr << "headless context: " << what << ", egl error 0x" << std::hex << eglGetError() << std::dec << '\n';
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+my_gl::HeadlessContext::HeadlessContext(uint32_t width, uint32_t height)
+    : _width{ width }
+    , _height{ height }
+{
+    std::cout << "Starting headless EGL context, OpenGL 4.5, " << width << 'x' << height << '\n';
+
+    const auto get_platform_display{ reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT")) };
+    if (!get_platform_display) {
+        fail("EGL_EXT_platform_base not supported");
+    }
+    EGLDisplay display{ get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr) };
+    EGLint major{ 0 };
+    EGLint minor{ 0 };
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        fail("no surfaceless display");
+    }
+    _display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        fail("desktop gl not supported");
+    }
+    // no config, there's no surface to match, EGL_KHR_no_config_context
+    const EGLint context_attribs[]{
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+    EGLContext context{ eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs) };
+    if (context == EGL_NO_CONTEXT) {
+        fail("can't create a 4.5 core context");
+    }
+    _context = context;
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        fail("can't make the context current");
+    }
+
+    // glewInit looks for a glx display first and fails without one, the context is all it needs
+    glewExperimental = GL_TRUE;
+    if (glewContextInit() != GLEW_OK) {
+        std::cout << "Failed to initialize GLEW" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    my_gl::init_gl_state();
+
+    glCreateRenderbuffers(1, &_color_id);
+    glNamedRenderbufferStorage(_color_id, GL_RGBA8, width, height);
+    glCreateRenderbuffers(1, &_depth_id);
+    glNamedRenderbufferStorage(_depth_id, GL_DEPTH_COMPONENT24, width, height);
+
+    glCreateFramebuffers(1, &_fbo_id);
+    glNamedFramebufferRenderbuffer(_fbo_id, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _color_id);
+    glNamedFramebufferRenderbuffer(_fbo_id, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depth_id);
+    if (glCheckNamedFramebufferStatus(_fbo_id, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fail("framebuffer incomplete");
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, _fbo_id);
+    glViewport(0, 0, width, height);
+}
+
+my_gl::HeadlessContext::~HeadlessContext() {
+    glDeleteFramebuffers(1, &_fbo_id);
+    glDeleteRenderbuffers(1, &_color_id);
+    glDeleteRenderbuffers(1, &_depth_id);
+
+    eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(_display, _context);
+    eglTerminate(_display);
+}
+
+std::vector<uint8_t> my_gl::HeadlessContext::read_pixels() const {
+    std::vector<uint8_t> pixels(static_cast<std::size_t>(_width) * _height * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glNamedFramebufferReadBuffer(_fbo_id, GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _fbo_id);
+    glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+uint64_t my_gl::HeadlessContext::checksum() const {
+    const std::vector<uint8_t> pixels{ read_pixels() };
+    return fnv1a(pixels.data(), pixels.size());
+}
@@ -1,8 +1,16 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
 #include <array>
+#include <iostream>
+#include <optional>
 #include <span>
+#include <string_view>
+#include <vector>
 #include "animation.hpp"
 #include "math.hpp"
 #include "matrix.hpp"
@@ -12,42 +20,122 @@
 #include "window.hpp"
 #include "renderer.hpp"
 #include "geometryObject.hpp"
+#include "headlessContext.hpp"
 #include "texture.hpp"
 #include "globals.hpp"
 #include "camera.hpp"
+#include "cloth.hpp"
 #include "meshes.hpp"
+#include "profiler.hpp"
+#include "replay.hpp"
+#include "trace.hpp"
 
-int main() {
-    my_gl::Window window{ my_gl::init_window() };
+int main(int argc, char** argv) {
+    // --record <path> saves frame durations and input of the session,
+    // --replay <path> plays them back and compares transforms every frame,
+    // --cubes <count> adds a static grid of world cubes, they are drawn instanced,
+    // --no-multi-draw issues instanced draws one by one even where multi draw indirect is supported,
+    // --stats prints primitives, culled ones and draw calls of a frame every second,
+    // --profile <path> records cpu scopes and gpu timestamps, prints their percentiles
+    // and writes the samples of the last frames as csv on exit,
+    // --trace <path> records chrome trace events, written on F12, on exit and every
+    // --trace-frames <count> frames, only in builds with TRACE=1,
+    // --headless <frames> renders that many frames offscreen without a window, each one simulated
+    // as 1/60 s, then prints frame timings and a checksum of the last image,
+    // --size <width>x<height> of the headless framebuffer
+    const char* replay_path{ nullptr };
+    std::size_t grid_cubes_count{ 0 };
+    bool is_multi_draw_enabled{ true };
+    bool is_printing_stats{ false };
+    const char* profile_path{ nullptr };
+    std::size_t headless_frames_count{ 0 };
+    uint32_t headless_width{ my_gl::globals::WindowProps::width };
+    uint32_t headless_height{ my_gl::globals::WindowProps::height };
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg{ argv[i] };
+        const bool has_value{ i + 1 < argc };
+        if ((arg == "--record" || arg == "--replay") && has_value) {
+            my_gl::globals::replay._mode = arg == "--record" ? my_gl::ReplayLog::Mode::RECORD : my_gl::ReplayLog::Mode::REPLAY;
+            replay_path = argv[++i];
+        }
+        else if (arg == "--cubes" && has_value) {
+            grid_cubes_count = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--no-multi-draw") {
+            is_multi_draw_enabled = false;
+        }
+        else if (arg == "--stats") {
+            is_printing_stats = true;
+        }
+        else if (arg == "--headless" && has_value) {
+            headless_frames_count = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--size" && has_value) {
+            char* height_str{ nullptr };
+            headless_width = std::strtoul(argv[++i], &height_str, 10);
+            headless_height = *height_str == 'x' ? std::strtoul(height_str + 1, nullptr, 10) : 0;
+            if (headless_width == 0 || headless_height == 0) {
+                std::cerr << "--size expects <width>x<height>, got " << argv[i] << '\n';
+                return 1;
+            }
+        }
+        else if (arg == "--profile" && has_value) {
+            profile_path = argv[++i];
+            my_gl::globals::profiler._enabled = true;
+        }
+#ifdef MY_GL_TRACING
+        else if (arg == "--trace" && has_value) {
+            my_gl::globals::tracer._enabled = true;
+            my_gl::globals::tracer._path = argv[++i];
+        }
+        else if (arg == "--trace-frames" && has_value) {
+            my_gl::globals::tracer._flush_after_frames = std::strtoull(argv[++i], nullptr, 10);
+        }
+#else
+        else if (arg == "--trace" || arg == "--trace-frames") {
+            std::cerr << arg << " is ignored, tracing isn't compiled in, build with TRACE=1\n";
+        }
+#endif
+    }
+    if (my_gl::globals::replay._mode == my_gl::ReplayLog::Mode::REPLAY && !my_gl::globals::replay.load(replay_path)) {
+        return 1;
+    }
+    MY_GL_TRACE_THREAD_NAME("main");
+
+    // one or the other, the headless context draws to its fbo
+    std::optional<my_gl::Window> window;
+    std::optional<my_gl::HeadlessContext> headless;
+    if (headless_frames_count > 0) {
+        headless.emplace(headless_width, headless_height);
+    }
+    else {
+        window.emplace(my_gl::init_window());
+    }
+    GLFWwindow* const window_ptr{ window ? window->ptr_raw() : nullptr };
+    const float aspect{
+        headless ? static_cast<float>(headless_width) / static_cast<float>(headless_height) : my_gl::globals::camera.aspect
+    };
 
     constexpr uint16_t texture_offset{ sizeof(float) * 3 * 4 * 6 };
     constexpr uint16_t color_offset{ texture_offset + sizeof(float) * 2 * 4 * 6 };
     constexpr uint16_t normal_offset{ color_offset + sizeof(float) * 3 * 4 * 6 };
 
+    constexpr uint16_t instance_stride{ sizeof(my_gl::InstanceData) };
+
     my_gl::Program world_shader{
-        "shaders/vert_shader_material.glsl",
-        "shaders/frag_shader_material.glsl",
-        // "shaders/vert_shader.glsl",
-        // "shaders/frag_shader.glsl",
+        "shaders/vert_shader_material_instanced.glsl",
+        "shaders/frag_shader_material_instanced.glsl",
+        // "shaders/vert_shader_material.glsl",
+        // "shaders/frag_shader_material.glsl",
         {
             { .name = "a_pos", .gl_type = GL_FLOAT, .count = 3, .byte_stride = 0, .byte_offset = 0 },
             // { .name = "a_color", .gl_type = GL_FLOAT, .count = 3, .byte_stride = 0, .byte_offset = color_offset },
             { .name = "a_normal", .gl_type = GL_FLOAT, .count = 3, .byte_stride = 0, .byte_offset = normal_offset },
-        },
-        {
-            { .name = "u_mvp_mat" },
-            { .name = "u_model_view_mat" },
-            { .name = "u_normal_mat" },
-            { .name = "u_view_pos" },
-            { .name = "u_material.ambient" },
-            { .name = "u_material.diffuse" },
-            { .name = "u_material.specular" },
-            { .name = "u_material.shininess" },
-            { .name = "u_light.position" },
-            { .name = "u_light.ambient" },
-            { .name = "u_light.diffuse" },
-            { .name = "u_light.specular" },
+            // per instance
+            { .name = "a_model_mat", .gl_type = GL_FLOAT, .count = 16, .byte_stride = instance_stride, .byte_offset = offsetof(my_gl::InstanceData, model_mat), .divisor = 1 },
+            { .name = "a_material", .gl_type = GL_UNSIGNED_INT, .count = 1, .byte_stride = instance_stride, .byte_offset = offsetof(my_gl::InstanceData, material), .divisor = 1 },
         }
+        // camera, light and materials come from the FrameData and MaterialTable blocks
     };
 
     my_gl::Program light_shader{
@@ -57,7 +145,6 @@ int main() {
             { .name = "a_pos", .gl_type = GL_FLOAT, .count = 3, .byte_stride = 0, .byte_offset = 0 },
         },
         {
-            { .name = "u_mvp_mat" },
             { .name = "u_color" }
         }
     };
@@ -154,8 +241,14 @@ int main() {
         },
     };
 
+    // elastic bounces, no friction
+    for (auto& body : physics) {
+        body._restitution = 1.0f;
+        body._friction = 0.0f;
+    }
+
     // primitives
-    std::array primitives = {
+    std::vector<my_gl::GeometryObjectPrimitive> primitives = {
         // world cube
         my_gl::GeometryObjectPrimitive{
             std::span<my_gl::TransformData>{world_transforms.begin(), 2},
@@ -166,7 +259,8 @@ int main() {
             vertex_arr_world,
             GL_TRIANGLES,
             my_gl::Material::EMERALD,
-            nullptr
+            nullptr,
+            false
         },
         my_gl::GeometryObjectPrimitive{
             std::span<my_gl::TransformData>{world_transforms.begin() + 2, 2},
@@ -177,7 +271,8 @@ int main() {
             vertex_arr_world,
             GL_TRIANGLES,
             my_gl::Material::RUBY,
-            nullptr
+            nullptr,
+            false
         },
         my_gl::GeometryObjectPrimitive{
             std::span<my_gl::TransformData>{world_transforms.begin() + 4, 2},
@@ -188,7 +283,8 @@ int main() {
             vertex_arr_world,
             GL_TRIANGLES,
             my_gl::Material::OBSIDIAN,
-            nullptr
+            nullptr,
+            false
         },
         // light
         my_gl::GeometryObjectPrimitive{
@@ -200,14 +296,87 @@ int main() {
             vertex_arr_light,
             GL_TRIANGLES,
             my_gl::Material::NO_MATERIAL,
-            nullptr
+            nullptr,
+            true
+        }
+    };
+
+    // grid behind the scene, sides as equal as the count allows
+    std::vector<my_gl::TransformData> grid_transforms;
+    grid_transforms.reserve(grid_cubes_count);
+    // and the banner below
+    primitives.reserve(primitives.size() + grid_cubes_count + 1);
+    const std::size_t grid_side{ static_cast<std::size_t>(std::ceil(std::cbrt(static_cast<float>(grid_cubes_count)))) };
+    for (std::size_t i = 0; i < grid_cubes_count; ++i) {
+        constexpr float spacing{ 0.3f };
+        const my_gl::math::Vec3<float> grid_pos{
+            (static_cast<float>(i % grid_side) - grid_side * 0.5f) * spacing,
+            (static_cast<float>(i / grid_side % grid_side) - grid_side * 0.5f) * spacing,
+            -static_cast<float>(i / (grid_side * grid_side)) * spacing - 5.0f,
+        };
+        grid_transforms.emplace_back(
+            my_gl::math::TransformationType::TRANSLATION,
+            std::vector{
+                my_gl::math::Matrix44<float>::translation(grid_pos),
+                my_gl::math::Matrix44<float>::scaling({ 0.1f, 0.1f, 0.1f }),
+            },
+            std::vector<my_gl::Animation<float>>{}
+        );
+        primitives.emplace_back(
+            std::span<my_gl::TransformData>{ &grid_transforms.back(), 1 },
+            nullptr,
+            36,
+            0,
+            world_shader,
+            vertex_arr_world,
+            GL_TRIANGLES,
+            static_cast<my_gl::Material::Type>(i % my_gl::Material::COUNT),
+            nullptr,
+            true
+        );
+    }
+
+    // banner behind the cubes, held by its top corners only so it sags and swings,
+    // its vertices change every step and are streamed through a dynamic vao
+    std::array cloths = {
+        my_gl::Cloth::grid(32, 24, 0.06f, { -0.93f, 1.2f, -1.0f }),
+    };
+    for (uint32_t x = 1; x + 1 < 32; ++x) {
+        cloths[0].pin(x, false);
+    }
+
+    my_gl::Program cloth_shader{
+        "shaders/vert_shader_material.glsl",
+        "shaders/frag_shader_material.glsl",
+        {
+            { .name = "a_pos", .gl_type = GL_FLOAT, .count = 3, .byte_stride = 0, .byte_offset = 0 },
+            { .name = "a_normal", .gl_type = GL_FLOAT, .count = 3, .byte_stride = 0, .byte_offset = static_cast<uint16_t>(cloths[0].normal_byte_offset()) },
         }
     };
 
+    my_gl::VertexArray vertex_arr_cloth{
+        cloths[0].mesh(),
+        cloth_shader,
+        GL_DYNAMIC_DRAW
+    };
+
+    primitives.emplace_back(
+        std::span<my_gl::TransformData>{},
+        nullptr,
+        vertex_arr_cloth._mesh.indices.size(),
+        0,
+        cloth_shader,
+        vertex_arr_cloth,
+        GL_TRIANGLES,
+        my_gl::Material::GOLD,
+        nullptr,
+        false
+    );
+
     // camera
     auto view_mat{ my_gl::globals::camera.get_view_mat() };
     auto proj_mat{ my_gl::math::Matrix44<float>::perspective_fov(
-        my_gl::globals::camera.fov, my_gl::globals::camera.aspect, 0.1f, 50.0f
+        my_gl::globals::camera.fov, aspect, 0.1f, 50.0f
     )};
 
     my_gl::Renderer renderer{
@@ -216,29 +385,44 @@ int main() {
         std::span<my_gl::GeometryObjectPrimitive>{primitives},
         std::move(view_mat),
         std::move(proj_mat),
+        // physics steps per second, max steps per frame
+        my_gl::FixedTimestep{ 60.0f, 8 }
     };
+    // cubes drift slowly, let them bounce anyway
+    renderer._simulation._physics_world._solver._settings.restitution_threshold = 0.0f;
+    renderer._render_queue._multi_draw_enabled = is_multi_draw_enabled;
+    renderer._simulation._cloths = cloths;
 
-    world_shader.set_uniform_value("u_light.position",
-        my_gl::globals::light.position
-    );
-    world_shader.set_uniform_value("u_light.ambient", my_gl::globals::light.ambient);
-    world_shader.set_uniform_value("u_light.diffuse", my_gl::globals::light.diffuse);
-    world_shader.set_uniform_value("u_light.specular", my_gl::globals::light.specular);
-
-    world_shader.set_uniform_value("u_view_pos",
-        // view coords
-        // 0.0f, 0.0f, 0.0f
-        // world coords
-        my_gl::globals::camera.camera_pos
-    );
     light_shader.set_uniform_value("u_color", 1.0f, 1.0f, 1.0f);
 
     bool is_rendering_started{false};
     my_gl::Duration_sec frame_duration{};
-    glfwSwapInterval(1);
+    if (window) {
+        glfwSwapInterval(1);
+    }
 
-    while (!glfwWindowShouldClose(window.ptr_raw())) {
+    my_gl::ReplayLog& replay{ my_gl::globals::replay };
+    const bool is_replaying{ replay._mode == my_gl::ReplayLog::Mode::REPLAY };
+    std::size_t frame_index{ 0 };
+    std::size_t checksum_mismatches{ 0 };
+    my_gl::Duration_sec replay_cpu_duration{};
+    my_gl::Duration_sec since_stats_print{};
+    // measured ones, the simulation is fed a fixed duration so the image doesn't depend on the machine
+    constexpr my_gl::Duration_sec headless_frame_duration{ 1.0f / 60.0f };
+    std::vector<float> headless_frame_durations;
+    headless_frame_durations.reserve(headless_frames_count);
+    if (is_replaying && window) {
+        // replay runs as fast as it can, vsync would only measure the display
+        glfwSwapInterval(0);
+    }
+
+    const auto is_running{ [&] {
+        return window ? !glfwWindowShouldClose(window_ptr) : frame_index < headless_frames_count;
+    } };
+    while (is_running() && !(is_replaying && frame_index >= replay.size())) {
+        MY_GL_TRACE_SCOPE("frame");
         auto frame_start{ std::chrono::steady_clock::now() };
+        my_gl::globals::profiler.begin_frame();
         if (!is_rendering_started) {
             renderer._rendering_time_start = frame_start;
             is_rendering_started = true;
@@ -250,28 +434,127 @@ int main() {
 
         renderer._view_mat = my_gl::globals::camera.get_view_mat();
         renderer._proj_mat = my_gl::math::Matrix44<float>::perspective_fov(
-            my_gl::globals::camera.fov, my_gl::globals::camera.aspect, 0.1f, 50.0f
+            my_gl::globals::camera.fov, aspect, 0.1f, 50.0f
         );
 
-        world_shader.set_uniform_value("u_light.position",
-            my_gl::globals::light.position
-        );
-        world_shader.set_uniform_value("u_view_pos",
-            // view coords:
-            // 0.0f, 0.0f, 0.0f
-            // world coords:
-            my_gl::globals::camera.camera_pos
-        );
+        renderer._light = my_gl::globals::light;
+        renderer._view_pos = my_gl::globals::camera.camera_pos;
+
+        renderer.render(frame_duration);
+
+        since_stats_print += frame_duration;
+        if (is_printing_stats && since_stats_print.count() >= 1.0f) {
+            since_stats_print = {};
+            const my_gl::FrameStats& stats{ renderer._frame_stats };
+            std::cout << "primitives " << stats.primitives << ", culled " << stats.culled
+                << ", draw calls " << stats.draw_calls << '\n';
+
+            // averaged over the frames since the last print
+            const my_gl::RenderTimings& timings{ renderer._timings };
+            const float to_avg_ms{ 1000.0f / static_cast<float>(std::max<uint64_t>(timings.frames, 1)) };
+            std::cout << "simulate " << timings.simulate.count() * to_avg_ms << " ms, transforms " << timings.transforms.count() * to_avg_ms
+                << " ms, cull " << timings.cull.count() * to_avg_ms << " ms, build draw list " << timings.build_draw_list.count() * to_avg_ms
+                << " ms, submit " << timings.submit.count() * to_avg_ms << " ms\n";
+            renderer.reset_timings();
+        }
 
-        float time_0to1 = my_gl::math::Global::map_duration_to01(renderer.get_curr_rendering_duration());
-        renderer.render(frame_duration, time_0to1);
+        const uint64_t checksum{ renderer.transforms_checksum() };
 
-        glfwSwapBuffers(window.ptr_raw());
-        glfwPollEvents();
+        if (window) {
+            {
+                MY_GL_TRACE_SCOPE("swap buffers");
+                glfwSwapBuffers(window_ptr);
+            }
+            glfwPollEvents();
+        }
+        else {
+            // nothing presents the frame, waiting for it keeps gpu time in the timings
+            MY_GL_TRACE_SCOPE("finish");
+            glFinish();
+        }
 
         frame_duration = std::chrono::steady_clock::now() - frame_start;
+        if (headless) {
+            headless_frame_durations.push_back(frame_duration.count());
+        }
+        if (is_replaying) {
+            // the recorded frame is fed back instead of the measured one
+            replay_cpu_duration += frame_duration;
+            const my_gl::ReplayLog::Frame& frame{ replay.frame(frame_index) };
+            if (frame.checksum != checksum) {
+                if (checksum_mismatches == 0) {
+                    std::cerr << "replay diverged at frame " << frame_index << '\n';
+                }
+                ++checksum_mismatches;
+            }
+            // recorded input was handled before delta_time took the new frame duration
+            for (const my_gl::InputEvent& event : replay.events(frame_index)) {
+                my_gl::apply_input(window_ptr, event);
+            }
+            frame_duration = my_gl::Duration_sec{ frame.duration };
+            my_gl::globals::delta_time = frame_duration.count();
+        }
+        else {
+            if (headless) {
+                frame_duration = headless_frame_duration;
+            }
+            my_gl::globals::delta_time = frame_duration.count();
+            if (replay._mode == my_gl::ReplayLog::Mode::RECORD) {
+                replay.record_frame(frame_duration, checksum);
+            }
+        }
+        ++frame_index;
         renderer.update_time(frame_duration);
-        my_gl::globals::delta_time = frame_duration.count();
+        my_gl::globals::profiler.end_frame();
+#ifdef MY_GL_TRACING
+        my_gl::globals::tracer.end_frame();
+#endif
+    }
+#ifdef MY_GL_TRACING
+    my_gl::globals::tracer.flush();
+#endif
+
+    if (headless && !headless_frame_durations.empty()) {
+        std::vector<float> sorted{ headless_frame_durations };
+        std::sort(sorted.begin(), sorted.end());
+        float total{ 0.0f };
+        for (float duration : sorted) {
+            total += duration;
+        }
+        const auto percentile_ms{ [&sorted](float fraction) {
+            return sorted[static_cast<std::size_t>(fraction * static_cast<float>(sorted.size() - 1) + 0.5f)] * 1000.0f;
+        } };
+        std::cout << "headless " << headless_width << 'x' << headless_height << ", " << sorted.size() << " frames in "
+            << total * 1000.0f << " ms, avg " << total * 1000.0f / static_cast<float>(sorted.size()) << " ms, p50 "
+            << percentile_ms(0.50f) << " ms, p95 " << percentile_ms(0.95f) << " ms, p99 " << percentile_ms(0.99f)
+            << " ms, max " << sorted.back() * 1000.0f << " ms\n";
+        std::cout << "image checksum " << std::hex << headless->checksum() << std::dec << '\n';
+    }
+
+    if (profile_path) {
+        const my_gl::Profiler& profiler{ my_gl::globals::profiler };
+        const auto print_stats{ [&profiler](const char* name, my_gl::ProfileSource source) {
+            const my_gl::ProfileStats stats{ profiler.stats(name, source) };
+            std::cout << (source == my_gl::ProfileSource::GPU ? "gpu " : "cpu ") << (*name ? name : "frame") << ": avg "
+                << stats.average.count() * 1000.0f << " ms, p50 " << stats.p50.count() * 1000.0f << " ms, p95 "
+                << stats.p95.count() * 1000.0f << " ms, p99 " << stats.p99.count() * 1000.0f << " ms, max "
+                << stats.max.count() * 1000.0f << " ms\n";
+        } };
+        for (const char* name : { "", "render", "simulation", "transforms", "cull", "build draw list", "submit" }) {
+            print_stats(name, my_gl::ProfileSource::CPU);
+        }
+        print_stats("submit", my_gl::ProfileSource::GPU);
+        profiler.write_csv(profile_path);
+    }
+
+    if (replay._mode == my_gl::ReplayLog::Mode::RECORD) {
+        replay.save(replay_path);
+    }
+    else if (is_replaying) {
+        std::cout << "replayed " << frame_index << " frames in " << replay_cpu_duration.count() * 1000.0f << " ms, "
+            << (frame_index > 0 ? replay_cpu_duration.count() * 1000.0f / frame_index : 0.0f) << " ms per frame, "
+            << checksum_mismatches << " checksum mismatches\n";
+        return checksum_mismatches == 0 ? 0 : 1;
     }
 
     return 0;
@@ -118,7 +118,7 @@ namespace my_gl {
 
         Boundaries Mesh::transform_boundaries(const my_gl::math::Matrix44<float>& mat) const {
             return Boundaries{
-                .ltn = mat * my_gl::math::Vec4<float>(boundaries->ltf),
+                .ltn = mat * my_gl::math::Vec4<float>(boundaries->ltn),
                 .ltf = mat * my_gl::math::Vec4<float>(boundaries->ltf),
                 .rtn = mat * my_gl::math::Vec4<float>(boundaries->rtn),
                 .rtf = mat * my_gl::math::Vec4<float>(boundaries->rtf),
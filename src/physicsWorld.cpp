@@ -0,0 +1,548 @@
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include "physicsWorld.hpp"
+#include "profiler.hpp"
+#include "simd.hpp"
+
+namespace {
+    using my_gl::simd::F32x4;
+
+    // pairs per narrowphase task, small chunks balance better, big ones have less overhead
+    constexpr std::size_t NARROWPHASE_CHUNK_SIZE{ 256 };
+    // bodies per integration task, a multiple of the simd width so chunks split the same blocks
+    constexpr std::size_t INTEGRATE_CHUNK_SIZE{ 16384 };
+    static_assert(INTEGRATE_CHUNK_SIZE % F32x4::width == 0);
+    // collision events room per body, resting piles see a few contacts per body each step
+    constexpr std::size_t EVENTS_PER_BODY{ 4 };
+
+    // vel += acc * dt, for a single axis, sleeping bodies are masked out
+    void integrate_velocity_axis(float* vel, const float* acc, const float* awake, std::size_t count, float step_duration) {
+        const F32x4 dt{ F32x4::broadcast(step_duration) };
+        std::size_t i{ 0 };
+
+        for (; i + F32x4::width <= count; i += F32x4::width) {
+            const F32x4 mask{ F32x4::load(awake + i) };
+            if (mask.any()) {
+                (F32x4::load(vel + i) + F32x4::load(acc + i) * dt * mask).store(vel + i);
+            }
+        }
+
+        // tail
+        for (; i < count; ++i) {
+            vel[i] += acc[i] * step_duration * awake[i];
+        }
+    }
+
+    // next_pos = pos + vel * dt, for a single axis
+    // blocks without awake bodies are skipped, both position buffers
+    // of a sleeping or static body hold the same value
+    void integrate_position_axis(const float* pos, float* next_pos, const float* vel, const float* awake, std::size_t count, float step_duration) {
+        const F32x4 dt{ F32x4::broadcast(step_duration) };
+        std::size_t i{ 0 };
+
+        for (; i + F32x4::width <= count; i += F32x4::width) {
+            if (F32x4::load(awake + i).any()) {
+                (F32x4::load(pos + i) + F32x4::load(vel + i) * dt).store(next_pos + i);
+            }
+        }
+
+        for (; i < count; ++i) {
+            next_pos[i] = pos[i] + vel[i] * step_duration;
+        }
+    }
+
+    // out = lhs + rhs, blocks without awake bodies are skipped
+    void add_axis(const float* lhs, const float* rhs, float* out, const float* awake, std::size_t count) {
+        std::size_t i{ 0 };
+
+        for (; i + F32x4::width <= count; i += F32x4::width) {
+            if (F32x4::load(awake + i).any()) {
+                (F32x4::load(lhs + i) + F32x4::load(rhs + i)).store(out + i);
+            }
+        }
+
+        for (; i < count; ++i) {
+            out[i] = lhs[i] + rhs[i];
+        }
+    }
+}
+
+my_gl::PhysicsWorld::PhysicsWorld(std::size_t body_capacity) {
+    reserve(body_capacity);
+}
+
+void my_gl::PhysicsWorld::reserve(std::size_t body_capacity) {
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        for (SoAVec3* arrays : { &_pos[0], &_pos[1], &_vel, &_acc, &_local_min, &_local_max, &_bounds_min, &_bounds_max }) {
+            (*arrays)[axis].reserve(body_capacity);
+        }
+    }
+    for (std::vector<float>* arrays : { &_inv_mass, &_restitution, &_friction, &_awake, &_sleep_time, &_island_sleep_time }) {
+        arrays->reserve(body_capacity);
+    }
+    _colliders.reserve(body_capacity);
+    _ccd.reserve(body_capacity);
+    _island_next.reserve(body_capacity);
+    _island_parent.reserve(body_capacity);
+    _events.reserve(body_capacity * EVENTS_PER_BODY);
+}
+
+my_gl::BodyId my_gl::PhysicsWorld::add_body(
+    const math::Vec3<float>&    position,
+    const math::Vec3<float>&    velocity,
+    const math::Vec3<float>&    acceleration,
+    float                       mass,
+    float                       restitution,
+    float                       friction
+)
+{
+    const bool is_static{ mass <= 0.0f };
+    const AABB empty_bounds;
+
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        _pos[0][axis].push_back(position[axis]);
+        _pos[1][axis].push_back(position[axis]);
+        _vel[axis].push_back(is_static ? 0.0f : velocity[axis]);
+        _acc[axis].push_back(is_static ? 0.0f : acceleration[axis]);
+        _local_min[axis].push_back(empty_bounds.min[axis]);
+        _local_max[axis].push_back(empty_bounds.max[axis]);
+        _bounds_min[axis].push_back(empty_bounds.min[axis]);
+        _bounds_max[axis].push_back(empty_bounds.max[axis]);
+    }
+    _inv_mass.push_back(is_static ? 0.0f : 1.0f / mass);
+    _restitution.push_back(restitution);
+    _friction.push_back(friction);
+    _awake.push_back(is_static ? 0.0f : 1.0f);
+    _colliders.push_back(Collider{});
+    _ccd.push_back(0);
+    _sleep_time.push_back(0.0f);
+    _island_sleep_time.push_back(0.0f);
+
+    const BodyId body{ static_cast<BodyId>(_inv_mass.size() - 1) };
+    _island_next.push_back(body);
+    _island_parent.push_back(body);
+    ++_moves;
+    return body;
+}
+
+void my_gl::PhysicsWorld::step(float step_duration) {
+    const ProfileScope profile_scope{ "physics step" };
+    using Clock = std::chrono::steady_clock;
+    // adds time since the last lap to the phase
+    auto lap_start{ Clock::now() };
+    auto lap{ [&lap_start](Duration_sec& phase) {
+        const auto now{ Clock::now() };
+        phase += now - lap_start;
+        lap_start = now;
+    } };
+
+    integrate_velocities(step_duration);
+    update_bounds();
+    sweep_bounds(step_duration);
+    lap(_timings.integrate);
+    _broadphase.find_pairs(_bounds_min, _bounds_max, _awake, _contact_margin, _pairs);
+    lap(_timings.broadphase);
+    find_contacts(step_duration);
+    lap(_timings.narrowphase);
+    // pairs inside of a woken island were skipped, collect them again
+    while (wake_touched()) {
+        _broadphase.find_pairs(_bounds_min, _bounds_max, _awake, _contact_margin, _pairs);
+        lap(_timings.broadphase);
+        find_contacts(step_duration);
+        lap(_timings.narrowphase);
+    }
+    _solver.solve(_manifolds, _vel, _inv_mass, _friction, _restitution, step_duration);
+    lap(_timings.solver);
+    integrate_positions(step_duration);
+    lap(_timings.integrate);
+    emit_events();
+    update_sleep(step_duration);
+    lap(_timings.events);
+    ++_timings.steps;
+}
+
+// every body only reads and writes its own slots, so chunks give the same result on any worker
+void my_gl::PhysicsWorld::integrate_velocities(float step_duration) {
+    const auto job{ [&](std::size_t begin, std::size_t end, uint32_t) {
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            integrate_velocity_axis(_vel[axis].data() + begin, _acc[axis].data() + begin, _awake.data() + begin, end - begin, step_duration);
+        }
+    } };
+
+    if (_thread_pool) {
+        _thread_pool->parallel_for(size(), INTEGRATE_CHUNK_SIZE, job);
+    }
+    else {
+        job(0, size(), 0);
+    }
+}
+
+void my_gl::PhysicsWorld::integrate_positions(float step_duration) {
+    const SoAVec3& pos{ curr_pos() };
+    SoAVec3& next_pos{ _pos[_curr_pos_index ^ 1] };
+    const auto job{ [&](std::size_t begin, std::size_t end, uint32_t) {
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            integrate_position_axis(
+                pos[axis].data() + begin, next_pos[axis].data() + begin, _vel[axis].data() + begin, _awake.data() + begin, end - begin, step_duration
+            );
+        }
+    } };
+
+    if (_thread_pool) {
+        _thread_pool->parallel_for(size(), INTEGRATE_CHUNK_SIZE, job);
+    }
+    else {
+        job(0, size(), 0);
+    }
+
+    _curr_pos_index ^= 1;
+    // sleeping and static bodies keep their place, a world that is all asleep didn't move
+    if (std::find(_awake.begin(), _awake.end(), 1.0f) != _awake.end()) {
+        ++_moves;
+    }
+}
+
+void my_gl::PhysicsWorld::update_bounds() {
+    const SoAVec3& pos{ curr_pos() };
+
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        add_axis(pos[axis].data(), _local_min[axis].data(), _bounds_min[axis].data(), _awake.data(), size());
+        add_axis(pos[axis].data(), _local_max[axis].data(), _bounds_max[axis].data(), _awake.data(), size());
+    }
+}
+
+// bounds of sleeping and static bodies are only updated when they are changed
+void my_gl::PhysicsWorld::update_body_bounds(BodyId body) {
+    const SoAVec3& pos{ curr_pos() };
+
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        _bounds_min[axis][body] = pos[axis][body] + _local_min[axis][body];
+        _bounds_max[axis][body] = pos[axis][body] + _local_max[axis][body];
+    }
+    _broadphase.bounds_changed(body);
+    ++_moves;
+}
+
+// grows broadphase bounds of ccd bodies by their motion during the step
+void my_gl::PhysicsWorld::sweep_bounds(float step_duration) {
+    for (const BodyId body : _ccd_bodies) {
+        if (!is_awake(body)) {
+            continue;
+        }
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            const float motion{ _vel[axis][body] * step_duration };
+            _bounds_min[axis][body] += std::min(motion, 0.0f);
+            _bounds_max[axis][body] += std::max(motion, 0.0f);
+        }
+    }
+}
+
+void my_gl::PhysicsWorld::find_contacts(float step_duration) {
+    const ProfileScope profile_scope{ "collision" };
+    _manifolds.clear();
+
+    if (!_thread_pool || _pairs.size() <= NARROWPHASE_CHUNK_SIZE) {
+        // pairs are sorted, so are manifolds
+        for (const BodyPair& pair : _pairs) {
+            ContactManifold manifold;
+            if (collide_pair(pair, step_duration, manifold)) {
+                _manifolds.push_back(manifold);
+            }
+        }
+        return;
+    }
+
+    // detect, chunks only read body state and write into own buffers
+    _worker_manifolds.resize(_thread_pool->size());
+    for (std::vector<ContactManifold>& buffer : _worker_manifolds) {
+        buffer.clear();
+    }
+    _contact_chunks.resize((_pairs.size() + NARROWPHASE_CHUNK_SIZE - 1) / NARROWPHASE_CHUNK_SIZE);
+
+    _thread_pool->parallel_for(_pairs.size(), NARROWPHASE_CHUNK_SIZE, [&](std::size_t begin, std::size_t end, uint32_t worker) {
+        std::vector<ContactManifold>& buffer{ _worker_manifolds[worker] };
+        ContactChunk& chunk{ _contact_chunks[begin / NARROWPHASE_CHUNK_SIZE] };
+        chunk.worker = worker;
+        chunk.begin = buffer.size();
+
+        for (std::size_t i = begin; i < end; ++i) {
+            ContactManifold manifold;
+            if (collide_pair(_pairs[i], step_duration, manifold)) {
+                buffer.push_back(manifold);
+            }
+        }
+        chunk.count = buffer.size() - chunk.begin;
+    });
+
+    // merge, chunks in order of pairs keep manifolds sorted by key,
+    // so the result is the same for any count of threads
+    for (const ContactChunk& chunk : _contact_chunks) {
+        const auto first{ _worker_manifolds[chunk.worker].begin() + chunk.begin };
+        _manifolds.insert(_manifolds.end(), first, first + chunk.count);
+    }
+}
+
+bool my_gl::PhysicsWorld::collide_pair(const BodyPair& pair, float step_duration, ContactManifold& manifold) const {
+    const BodyId a{ pair.body_a };
+    const BodyId b{ pair.body_b };
+    const AABB bounds_a{ world_bounds(a) };
+    const AABB bounds_b{ world_bounds(b) };
+    manifold = ContactManifold{
+        .key = pair.key(),
+        .body_a = a,
+        .body_b = b,
+        .normal = { 0.0f, 0.0f, 0.0f },
+        .point = { 0.0f, 0.0f, 0.0f },
+        .depth = 0.0f,
+    };
+
+    // boxes are the common case and their bounds are already at hand
+    const bool touching{
+        _colliders[a].type == Collider::Type::BOX && _colliders[b].type == Collider::Type::BOX
+            ? collide_aabb(bounds_a, bounds_b, manifold, _contact_margin)
+            : collide(_colliders[a], position(a), _colliders[b], position(b), manifold, _contact_margin)
+    };
+
+    // too far for a regular contact, a fast mover may still reach the other body during the step,
+    // speculative contact from the time of impact stops it at the surface
+    return touching ||
+        ((_ccd[a] || _ccd[b]) && sweep_aabb(bounds_a, bounds_b, (velocity(b) - velocity(a)) * step_duration, manifold));
+}
+
+bool my_gl::PhysicsWorld::wake_touched() {
+    bool woke{ false };
+
+    // every manifold has an awake body, so a sleeping one in it was just touched
+    for (const ContactManifold& manifold : _manifolds) {
+        for (const BodyId body : { manifold.body_a, manifold.body_b }) {
+            if (_inv_mass[body] != 0.0f && !is_awake(body)) {
+                wake(body);
+                woke = true;
+            }
+        }
+    }
+
+    return woke;
+}
+
+void my_gl::PhysicsWorld::update_sleep(float step_duration) {
+    const float velocity_threshold_sq{ _sleep_settings.velocity_threshold * _sleep_settings.velocity_threshold };
+
+    for (BodyId body = 0; body < size(); ++body) {
+        _island_parent[body] = body;
+        _island_sleep_time[body] = std::numeric_limits<float>::max();
+        if (!is_awake(body)) {
+            continue;
+        }
+        const math::Vec3<float> vel{ velocity(body) };
+        const float speed_sq{ vel.dot(vel) };
+        _sleep_time[body] = speed_sq > velocity_threshold_sq ? 0.0f : _sleep_time[body] + step_duration;
+    }
+
+    // bodies touching each other form an island, static bodies don't join them
+    for (const ContactManifold& manifold : _manifolds) {
+        if (_inv_mass[manifold.body_a] == 0.0f || _inv_mass[manifold.body_b] == 0.0f) {
+            continue;
+        }
+        const BodyId root_a{ find_island(manifold.body_a) };
+        const BodyId root_b{ find_island(manifold.body_b) };
+        _island_parent[std::max(root_a, root_b)] = std::min(root_a, root_b);
+    }
+
+    // island sleeps only as a whole
+    for (BodyId body = 0; body < size(); ++body) {
+        if (is_awake(body)) {
+            float& island_time{ _island_sleep_time[find_island(body)] };
+            island_time = std::min(island_time, _sleep_time[body]);
+        }
+    }
+
+    SoAVec3& prev{ _pos[_curr_pos_index ^ 1] };
+    const SoAVec3& pos{ curr_pos() };
+
+    for (BodyId body = 0; body < size(); ++body) {
+        if (!is_awake(body)) {
+            continue;
+        }
+        const BodyId root{ find_island(body) };
+        if (_island_sleep_time[root] < _sleep_settings.time_to_sleep) {
+            continue;
+        }
+
+        _awake[body] = 0.0f;
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            _vel[axis][body] = 0.0f;
+            // position integration skips sleeping bodies, both buffers must match
+            prev[axis][body] = pos[axis][body];
+        }
+        update_body_bounds(body);
+
+        // link into the ring of the root
+        if (body != root) {
+            _island_next[body] = _island_next[root];
+            _island_next[root] = body;
+        }
+    }
+}
+
+void my_gl::PhysicsWorld::emit_events() {
+    auto push_event{ [this](CollisionEvent::Type type, const ContactManifold& manifold) {
+        _events.push(CollisionEvent{
+            .type = type,
+            .body_a = manifold.body_a,
+            .body_b = manifold.body_b,
+            .normal = manifold.normal,
+            .depth = manifold.depth,
+        });
+    } };
+
+    // pairs of sleeping bodies aren't tested, they stay touching without events
+    auto end_or_keep{ [&](const ContactManifold& manifold) {
+        if (!is_awake(manifold.body_a) && !is_awake(manifold.body_b)) {
+            _next_touching.push_back(manifold);
+        }
+        else {
+            push_event(CollisionEvent::Type::END, manifold);
+        }
+    } };
+
+    _next_touching.clear();
+    std::size_t prev{ 0 };
+
+    // both sequences are sorted by key, speculative contact touches
+    // only once the solver had to push to close its gap
+    for (const ContactManifold& manifold : _manifolds) {
+        if (manifold.depth < 0.0f && manifold.normal_impulse == 0.0f) {
+            continue;
+        }
+
+        for (; prev < _touching.size() && _touching[prev].key < manifold.key; ++prev) {
+            end_or_keep(_touching[prev]);
+        }
+
+        if (prev < _touching.size() && _touching[prev].key == manifold.key) {
+            push_event(CollisionEvent::Type::PERSIST, manifold);
+            ++prev;
+        }
+        else {
+            push_event(CollisionEvent::Type::BEGIN, manifold);
+        }
+        _next_touching.push_back(manifold);
+    }
+
+    for (; prev < _touching.size(); ++prev) {
+        end_or_keep(_touching[prev]);
+    }
+
+    std::swap(_touching, _next_touching);
+}
+
+my_gl::BodyId my_gl::PhysicsWorld::find_island(BodyId body) {
+    while (_island_parent[body] != body) {
+        // path halving
+        _island_parent[body] = _island_parent[_island_parent[body]];
+        body = _island_parent[body];
+    }
+    return body;
+}
+
+void my_gl::PhysicsWorld::wake(BodyId body) {
+    if (_inv_mass[body] == 0.0f || is_awake(body)) {
+        return;
+    }
+
+    BodyId curr{ body };
+    do {
+        const BodyId next{ _island_next[curr] };
+        _awake[curr] = 1.0f;
+        _sleep_time[curr] = 0.0f;
+        _broadphase.wake(curr);
+        _island_next[curr] = curr;
+        curr = next;
+    } while (curr != body);
+}
+
+void my_gl::PhysicsWorld::set_local_bounds(BodyId body, const AABB& local_bounds) {
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        _local_min[axis][body] = local_bounds.min[axis];
+        _local_max[axis][body] = local_bounds.max[axis];
+    }
+    update_body_bounds(body);
+    _colliders[body] = Collider::box(local_bounds);
+}
+
+void my_gl::PhysicsWorld::set_collider(BodyId body, const Collider& collider) {
+    set_local_bounds(body, collider.local_bounds());
+    _colliders[body] = collider;
+}
+
+void my_gl::PhysicsWorld::set_ccd(BodyId body, bool enabled) {
+    if (static_cast<bool>(_ccd[body]) == enabled) {
+        return;
+    }
+
+    _ccd[body] = enabled;
+    if (enabled) {
+        _ccd_bodies.push_back(body);
+    }
+    else {
+        _ccd_bodies.erase(std::find(_ccd_bodies.begin(), _ccd_bodies.end(), body));
+    }
+}
+
+// not the broadphase bounds, those are swept for ccd bodies
+my_gl::AABB my_gl::PhysicsWorld::world_bounds(BodyId body) const {
+    const SoAVec3& pos{ curr_pos() };
+    return AABB{
+        .min = { pos[0][body] + _local_min[0][body], pos[1][body] + _local_min[1][body], pos[2][body] + _local_min[2][body] },
+        .max = { pos[0][body] + _local_max[0][body], pos[1][body] + _local_max[1][body], pos[2][body] + _local_max[2][body] },
+    };
+}
+
+my_gl::math::Vec3<float> my_gl::PhysicsWorld::position(BodyId body) const {
+    const SoAVec3& pos{ curr_pos() };
+    return { pos[0][body], pos[1][body], pos[2][body] };
+}
+
+my_gl::math::Vec3<float> my_gl::PhysicsWorld::interpolated_position(BodyId body, float alpha) const {
+    const SoAVec3& pos{ curr_pos() };
+    const SoAVec3& prev{ prev_pos() };
+    return {
+        prev[0][body] + (pos[0][body] - prev[0][body]) * alpha,
+        prev[1][body] + (pos[1][body] - prev[1][body]) * alpha,
+        prev[2][body] + (pos[2][body] - prev[2][body]) * alpha,
+    };
+}
+
+my_gl::math::Vec3<float> my_gl::PhysicsWorld::velocity(BodyId body) const {
+    return { _vel[0][body], _vel[1][body], _vel[2][body] };
+}
+
+my_gl::math::Vec3<float> my_gl::PhysicsWorld::acceleration(BodyId body) const {
+    return { _acc[0][body], _acc[1][body], _acc[2][body] };
+}
+
+void my_gl::PhysicsWorld::set_position(BodyId body, const math::Vec3<float>& position) {
+    // teleport, no interpolation from the old place
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        _pos[0][axis][body] = position[axis];
+        _pos[1][axis][body] = position[axis];
+    }
+    update_body_bounds(body);
+    wake(body);
+}
+
+void my_gl::PhysicsWorld::set_velocity(BodyId body, const math::Vec3<float>& velocity) {
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        _vel[axis][body] = velocity[axis];
+    }
+    wake(body);
+}
+
+void my_gl::PhysicsWorld::set_acceleration(BodyId body, const math::Vec3<float>& acceleration) {
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        _acc[axis][body] = acceleration[axis];
+    }
+    wake(body);
+}
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include "profiler.hpp"
+#include "trace.hpp"
+
+namespace my_gl {
+    namespace globals {
+        Profiler profiler;
+    }
+}
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // nearest rank, sorted must not be empty
+    my_gl::Duration_sec percentile(const std::vector<float>& sorted, float fraction) {
+        const std::size_t rank{ static_cast<std::size_t>(fraction * static_cast<float>(sorted.size() - 1) + 0.5f) };
+        return my_gl::Duration_sec{ sorted[rank] };
+    }
+
+    const char* source_name(my_gl::ProfileSource source) {
+        return source == my_gl::ProfileSource::GPU ? "gpu" : "cpu";
+    }
+}
+
+void my_gl::Profiler::begin_frame() {
+    if (!_enabled) {
+        return;
+    }
+    assert(!_is_in_frame && "previous frame wasn't ended");
+
+    ProfileFrame& frame{ _frames[_frame_index % FRAMES_COUNT] };
+    frame.index = _frame_index;
+    frame.duration = {};
+    frame.samples.clear();
+
+    _open_scopes.clear();
+    _frame_thread = std::this_thread::get_id();
+    _is_in_frame = true;
+    _frame_start = Clock::now();
+}
+
+void my_gl::Profiler::end_frame() {
+    if (!_is_in_frame) {
+        return;
+    }
+    assert(_open_scopes.empty() && "scope still open at the end of the frame");
+
+    _frames[_frame_index % FRAMES_COUNT].duration = Clock::now() - _frame_start;
+    _is_in_frame = false;
+    ++_frame_index;
+}
+
+uint32_t my_gl::Profiler::begin_scope(const char* name) {
+    if (!_is_in_frame || std::this_thread::get_id() != _frame_thread) {
+        return INVALID_SCOPE;
+    }
+
+    std::vector<ProfileSample>& samples{ _frames[_frame_index % FRAMES_COUNT].samples };
+    const uint32_t scope{ static_cast<uint32_t>(samples.size()) };
+    samples.push_back(ProfileSample{
+        .name = name,
+        .source = ProfileSource::CPU,
+        .depth = static_cast<uint16_t>(_open_scopes.size()),
+        .start = Clock::now() - _frame_start,
+        .duration = {},
+    });
+    _open_scopes.push_back(scope);
+    return scope;
+}
+
+void my_gl::Profiler::end_scope(uint32_t scope) {
+    if (scope == INVALID_SCOPE || !_is_in_frame) {
+        return;
+    }
+    assert(!_open_scopes.empty() && _open_scopes.back() == scope && "scopes must end in reverse order");
+
+    ProfileSample& sample{ _frames[_frame_index % FRAMES_COUNT].samples[scope] };
+    sample.duration = Duration_sec{ Clock::now() - _frame_start } - sample.start;
+    _open_scopes.pop_back();
+}
+
+void my_gl::Profiler::add_gpu_sample(uint64_t frame_index, const char* name, Duration_sec start, Duration_sec duration) {
+    ProfileFrame& frame{ _frames[frame_index % FRAMES_COUNT] };
+    if (frame.index != frame_index || frame_index >= _frame_index + (_is_in_frame ? 1 : 0)) {
+        return;
+    }
+
+    frame.samples.push_back(ProfileSample{
+        .name = name,
+        .source = ProfileSource::GPU,
+        .depth = 0,
+        .start = start,
+        .duration = duration,
+    });
+}
+
+const my_gl::ProfileFrame* my_gl::Profiler::frame(uint64_t frame_index) const {
+    const ProfileFrame& frame{ _frames[frame_index % FRAMES_COUNT] };
+    // not recorded yet, or overwritten since
+    if (frame_index >= _frame_index || frame.index != frame_index) {
+        return nullptr;
+    }
+    return &frame;
+}
+
+my_gl::ProfileStats my_gl::Profiler::stats(std::string_view name, ProfileSource source) const {
+    std::vector<float> durations;
+    durations.reserve(FRAMES_COUNT);
+
+    const uint64_t first{ _frame_index > FRAMES_COUNT ? _frame_index - FRAMES_COUNT : 0 };
+    for (uint64_t i = first; i < _frame_index; ++i) {
+        const ProfileFrame* frame{ this->frame(i) };
+        if (!frame) {
+            continue;
+        }
+        if (name.empty()) {
+            durations.push_back(frame->duration.count());
+            continue;
+        }
+
+        float duration{ 0.0f };
+        bool is_found{ false };
+        for (const ProfileSample& sample : frame->samples) {
+            if (sample.source == source && name == sample.name) {
+                duration += sample.duration.count();
+                is_found = true;
+            }
+        }
+        if (is_found) {
+            durations.push_back(duration);
+        }
+    }
+
+    ProfileStats stats{};
+    if (durations.empty()) {
+        return stats;
+    }
+
+    std::sort(durations.begin(), durations.end());
+    float sum{ 0.0f };
+    for (float duration : durations) {
+        sum += duration;
+    }
+    stats.frames = static_cast<uint32_t>(durations.size());
+    stats.average = Duration_sec{ sum / static_cast<float>(durations.size()) };
+    stats.p50 = percentile(durations, 0.50f);
+    stats.p95 = percentile(durations, 0.95f);
+    stats.p99 = percentile(durations, 0.99f);
+    stats.max = Duration_sec{ durations.back() };
+    return stats;
+}
+
+bool my_gl::Profiler::write_csv(const char* path) const {
+    std::ofstream file{ path };
+    if (!file) {
+        std::cerr << "can't open profile output " << path << '\n';
+        return false;
+    }
+
+    file << "frame,frame_ms,source,name,depth,start_ms,duration_ms\n";
+    const uint64_t first{ _frame_index > FRAMES_COUNT ? _frame_index - FRAMES_COUNT : 0 };
+    for (uint64_t i = first; i < _frame_index; ++i) {
+        const ProfileFrame* frame{ this->frame(i) };
+        if (!frame) {
+            continue;
+        }
+        for (const ProfileSample& sample : frame->samples) {
+            file << frame->index << ',' << frame->duration.count() * 1000.0f << ',' << source_name(sample.source) << ','
+                << sample.name << ',' << sample.depth << ',' << sample.start.count() * 1000.0f << ','
+                << sample.duration.count() * 1000.0f << '\n';
+        }
+    }
+
+    return static_cast<bool>(file);
+}
+
+// also traced, on any thread
+my_gl::ProfileScope::ProfileScope(const char* name)
+    : _scope{ globals::profiler.begin_scope(name) }
+{
+#ifdef MY_GL_TRACING
+    globals::tracer.begin(name);
+#endif
+}
+
+my_gl::ProfileScope::~ProfileScope() {
+#ifdef MY_GL_TRACING
+    globals::tracer.end();
+#endif
+    globals::profiler.end_scope(_scope);
+}
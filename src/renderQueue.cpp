@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include "geometryObject.hpp"
+#include "glState.hpp"
+#include "renderQueue.hpp"
+#include "renderer.hpp"
+#include "threadPool.hpp"
+
+namespace {
+    constexpr uint32_t PROGRAM_BITS{ 8 };
+    constexpr uint32_t VAO_BITS{ 10 };
+    constexpr uint32_t TEXTURE_BITS{ 10 };
+    constexpr uint32_t MATERIAL_BITS{ 5 };
+    constexpr uint32_t DEPTH_BITS{ 24 };
+    constexpr uint32_t STATE_BITS{ PROGRAM_BITS + VAO_BITS + TEXTURE_BITS + MATERIAL_BITS };
+    constexpr uint32_t UNUSED_BITS{ 64 - 1 - STATE_BITS - DEPTH_BITS };
+
+    // regions grow when a frame doesn't fit
+    constexpr std::size_t INITIAL_STREAM_BYTE_SIZE{ 1 << 20 };
+    constexpr std::size_t INSTANCE_BYTE_ALIGNMENT{ 16 };
+    // packets written and recorded by one job
+    constexpr std::size_t RECORD_CHUNK_SIZE{ 1024 };
+
+    constexpr uint64_t field(uint32_t value, uint32_t bits) {
+        return value & ((uint64_t{ 1 } << bits) - 1);
+    }
+
+    bool can_share_state(const my_gl::GeometryObjectPrimitive& lhs, const my_gl::GeometryObjectPrimitive& rhs) {
+        return &lhs._program == &rhs._program
+            && &lhs._vao == &rhs._vao
+            && lhs._texture == rhs._texture
+            && lhs._draw_type == rhs._draw_type
+            && lhs._is_transparent == rhs._is_transparent;
+    }
+
+    bool can_share_draw(const my_gl::GeometryObjectPrimitive& lhs, const my_gl::GeometryObjectPrimitive& rhs) {
+        return can_share_state(lhs, rhs)
+            && lhs._vertices_count == rhs._vertices_count
+            && lhs._buffer_byte_offset == rhs._buffer_byte_offset;
+    }
+
+    // bits of a non negative float grow with its value, top ones keep the order
+    uint32_t quantize_depth(float view_depth) {
+        const float depth{ std::max(view_depth, 0.0f) };
+        return std::bit_cast<uint32_t>(depth) >> (32 - 1 - DEPTH_BITS);
+    }
+}
+
+uint64_t my_gl::RenderQueue::make_key(uint32_t program_id, uint32_t vao_id, uint32_t texture_id, uint32_t material, float view_depth, bool is_transparent) {
+    uint64_t state{ field(program_id, PROGRAM_BITS) };
+    state = (state << VAO_BITS) | field(vao_id, VAO_BITS);
+    state = (state << TEXTURE_BITS) | field(texture_id, TEXTURE_BITS);
+    state = (state << MATERIAL_BITS) | field(material, MATERIAL_BITS);
+
+    const uint64_t depth{ quantize_depth(view_depth) };
+    uint64_t key;
+    if (is_transparent) {
+        const uint64_t inverted_depth{ field(~static_cast<uint32_t>(depth), DEPTH_BITS) };
+        key = (uint64_t{ 1 } << 63) | (inverted_depth << (STATE_BITS + UNUSED_BITS)) | (state << UNUSED_BITS);
+    }
+    else {
+        key = (state << (DEPTH_BITS + UNUSED_BITS)) | (depth << UNUSED_BITS);
+    }
+
+    return key;
+}
+
+void my_gl::RenderQueue::push(const GeometryObjectPrimitive& primitive, float view_depth) {
+    _packets.push_back(DrawPacket{
+        .key = make_key(
+            primitive._program.get_id(),
+            primitive._vao._vao_id,
+            primitive._texture ? primitive._texture->_id : 0,
+            primitive._material_type,
+            view_depth,
+            primitive._is_transparent
+        ),
+        .primitive = &primitive,
+    });
+}
+
+void my_gl::RenderQueue::sort() {
+    _scratch.resize(_packets.size());
+
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        std::array<std::size_t, 256> offsets{};
+        for (const DrawPacket& packet : _packets) {
+            ++offsets[(packet.key >> shift) & 0xff];
+        }
+        // every key has the same byte, the pass wouldn't move anything
+        if (std::find(offsets.begin(), offsets.end(), _packets.size()) != offsets.end()) {
+            continue;
+        }
+
+        std::size_t sum{ 0 };
+        for (std::size_t& offset : offsets) {
+            const std::size_t count{ offset };
+            offset = sum;
+            sum += count;
+        }
+        for (const DrawPacket& packet : _packets) {
+            _scratch[offsets[(packet.key >> shift) & 0xff]++] = packet;
+        }
+        _packets.swap(_scratch);
+    }
+}
+
+void my_gl::RenderQueue::build_batches() {
+    _batches.clear();
+    _buckets.clear();
+    _packet_buckets.resize(_packets.size());
+
+    for (uint32_t i = 0; i < _packets.size();) {
+        const GeometryObjectPrimitive& first{ *_packets[i].primitive };
+        DrawBatch batch{ .first_packet = i, .packet_count = 1, .first_instance = 0, .data_byte_offset = 0 };
+
+        if (first._vao._is_instanced) {
+            while (i + batch.packet_count < _packets.size() && can_share_draw(first, *_packets[i + batch.packet_count].primitive)) {
+                ++batch.packet_count;
+            }
+        }
+
+        // instanced batches differing only in draw range share a bucket
+        const bool is_in_last_bucket{
+            first._vao._is_instanced
+            && !_buckets.empty()
+            && can_share_state(*_packets[_buckets.back().first_packet].primitive, first)
+        };
+        if (is_in_last_bucket) {
+            DrawBucket& bucket{ _buckets.back() };
+            batch.first_instance = bucket.instance_count;
+            ++bucket.batch_count;
+            bucket.instance_count += batch.packet_count;
+        }
+        else {
+            _buckets.push_back(DrawBucket{
+                .first_packet = i,
+                .first_batch = static_cast<uint32_t>(_batches.size()),
+                .batch_count = 1,
+                .instance_count = batch.packet_count,
+                .data_byte_offset = 0,
+                .commands_byte_offset = 0,
+                .data = nullptr,
+                .commands = nullptr,
+            });
+        }
+
+        std::fill_n(_packet_buckets.begin() + i, batch.packet_count, static_cast<uint32_t>(_buckets.size() - 1));
+        _batches.push_back(batch);
+        i += batch.packet_count;
+    }
+}
+
+void my_gl::RenderQueue::allocate_draw_data() {
+    if (!_stream) {
+        GLint alignment{ 0 };
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        _uniform_byte_alignment = std::max(static_cast<std::size_t>(alignment), INSTANCE_BYTE_ALIGNMENT);
+        _stream.emplace(INITIAL_STREAM_BYTE_SIZE);
+    }
+    _is_multi_draw = _multi_draw_enabled && (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect);
+
+    // worst case, every allocation is padded to its alignment
+    std::size_t frame_byte_size{ 0 };
+    for (const DrawBucket& bucket : _buckets) {
+        if (_packets[bucket.first_packet].primitive->_vao._is_instanced) {
+            frame_byte_size += sizeof(InstanceData) * bucket.instance_count + INSTANCE_BYTE_ALIGNMENT;
+            if (_is_multi_draw) {
+                frame_byte_size += sizeof(DrawElementsIndirectCommand) * bucket.batch_count + INSTANCE_BYTE_ALIGNMENT;
+            }
+        }
+        else {
+            frame_byte_size += sizeof(ObjectDataStd140) + _uniform_byte_alignment;
+        }
+    }
+
+    _stream->begin_frame(frame_byte_size);
+    for (DrawBucket& bucket : _buckets) {
+        if (!_packets[bucket.first_packet].primitive->_vao._is_instanced) {
+            const StreamAllocation allocation{ _stream->allocate(sizeof(ObjectDataStd140), _uniform_byte_alignment) };
+            bucket.data_byte_offset = allocation.byte_offset;
+            bucket.data = allocation.data;
+            _batches[bucket.first_batch].data_byte_offset = allocation.byte_offset;
+            continue;
+        }
+
+        // instances of the whole bucket are contiguous, base instance picks those of a draw
+        const StreamAllocation instances{ _stream->allocate(sizeof(InstanceData) * bucket.instance_count, INSTANCE_BYTE_ALIGNMENT) };
+        bucket.data_byte_offset = instances.byte_offset;
+        bucket.data = instances.data;
+        for (uint32_t i = 0; i < bucket.batch_count; ++i) {
+            DrawBatch& batch{ _batches[bucket.first_batch + i] };
+            batch.data_byte_offset = bucket.data_byte_offset + sizeof(InstanceData) * batch.first_instance;
+        }
+
+        if (_is_multi_draw) {
+            const StreamAllocation commands{ _stream->allocate(sizeof(DrawElementsIndirectCommand) * bucket.batch_count, INSTANCE_BYTE_ALIGNMENT) };
+            bucket.commands_byte_offset = commands.byte_offset;
+            bucket.commands = commands.data;
+        }
+    }
+}
+
+void my_gl::RenderQueue::record(
+    std::size_t begin,
+    std::size_t end,
+    CommandList& list,
+    const math::Matrix44<float>& view_mat,
+    const math::Matrix44<float>& view_proj_mat
+)
+{
+    list.clear();
+
+    for (std::size_t i = begin; i < end; ++i) {
+        const GeometryObjectPrimitive& primitive{ *_packets[i].primitive };
+        const uint32_t bucket_index{ _packet_buckets[i] };
+        const DrawBucket& bucket{ _buckets[bucket_index] };
+
+        // mapped memory is write combined, whole structs are copied in order
+        if (primitive._vao._is_instanced) {
+            const InstanceData instance{ primitive.instance_data() };
+            std::memcpy(bucket.data + sizeof(InstanceData) * (i - bucket.first_packet), &instance, sizeof(InstanceData));
+        }
+        else {
+            const ObjectDataStd140 object_data{ primitive.object_data(view_mat, view_proj_mat) };
+            std::memcpy(bucket.data, &object_data, sizeof(ObjectDataStd140));
+        }
+
+        if (i == bucket.first_packet) {
+            record_bucket(bucket_index, list);
+        }
+    }
+}
+
+// replay is in bucket order, so the state left by the previous bucket is known
+void my_gl::RenderQueue::record_bucket(uint32_t bucket_index, CommandList& list) {
+    const DrawBucket& bucket{ _buckets[bucket_index] };
+    const GeometryObjectPrimitive& primitive{ *_packets[bucket.first_packet].primitive };
+    const GeometryObjectPrimitive* previous{ bucket_index > 0 ? _packets[_buckets[bucket_index - 1].first_packet].primitive : nullptr };
+
+    if (primitive._is_transparent != (previous && previous->_is_transparent)) {
+        // transparent ones are last, they blend over what is drawn and don't hide each other
+        list.record(commands::SetTransparent{ .is_transparent = primitive._is_transparent });
+    }
+    if (!previous || &primitive._program != &previous->_program) {
+        list.record(commands::UseProgram{ .program = &primitive._program });
+    }
+    if (!previous || &primitive._vao != &previous->_vao) {
+        list.record(commands::BindVertexArray{ .vao = &primitive._vao });
+    }
+    if (primitive._texture && (!previous || primitive._texture != previous->_texture)) {
+        list.record(commands::BindTexture{ .texture = primitive._texture });
+    }
+
+    const uint32_t stream_id{ _stream->id() };
+    if (!primitive._vao._is_instanced) {
+        list.record(commands::BindObjectData{ .buffer_id = stream_id, .byte_offset = bucket.data_byte_offset });
+        list.record(primitive.draw_command(0));
+    }
+    else if (_is_multi_draw) {
+        for (uint32_t i = 0; i < bucket.batch_count; ++i) {
+            const DrawBatch& batch{ _batches[bucket.first_batch + i] };
+            const GeometryObjectPrimitive& batch_primitive{ *_packets[batch.first_packet].primitive };
+            const DrawElementsIndirectCommand command{
+                .count = static_cast<uint32_t>(batch_primitive._vertices_count),
+                .instance_count = batch.packet_count,
+                .first_index = static_cast<uint32_t>(batch_primitive._buffer_byte_offset / sizeof(uint16_t)),
+                .base_vertex = 0,
+                .base_instance = batch.first_instance,
+            };
+            std::memcpy(bucket.commands + sizeof(DrawElementsIndirectCommand) * i, &command, sizeof(DrawElementsIndirectCommand));
+        }
+
+        list.record(commands::AttachInstances{ .vao = &primitive._vao, .buffer_id = stream_id, .byte_offset = bucket.data_byte_offset });
+        list.record(commands::MultiDrawElementsIndirect{
+            .mode = primitive._draw_type,
+            .buffer_id = stream_id,
+            .commands_byte_offset = bucket.commands_byte_offset,
+            .draw_count = bucket.batch_count,
+        });
+    }
+    else {
+        // no base instance needed, each draw attaches its own instances
+        for (uint32_t i = 0; i < bucket.batch_count; ++i) {
+            const DrawBatch& batch{ _batches[bucket.first_batch + i] };
+            list.record(commands::AttachInstances{ .vao = &primitive._vao, .buffer_id = stream_id, .byte_offset = batch.data_byte_offset });
+            list.record(_packets[batch.first_packet].primitive->draw_command(batch.packet_count));
+        }
+    }
+
+    if (bucket_index + 1 == _buckets.size() && primitive._is_transparent) {
+        list.record(commands::SetTransparent{ .is_transparent = false });
+    }
+}
+
+void my_gl::RenderQueue::execute(const math::Matrix44<float>& view_mat, const math::Matrix44<float>& view_proj_mat, ThreadPool* thread_pool) {
+    _draw_calls = 0;
+    if (_packets.empty()) {
+        return;
+    }
+
+    build_batches();
+    allocate_draw_data();
+
+    const std::size_t chunk_count{ (_packets.size() + RECORD_CHUNK_SIZE - 1) / RECORD_CHUNK_SIZE };
+    if (_command_lists.size() < chunk_count) {
+        _command_lists.resize(chunk_count);
+    }
+    // chunk index picks the list, so the order doesn't depend on which worker ran it
+    const auto job{ [&](std::size_t begin, std::size_t end, uint32_t) {
+        record(begin, end, _command_lists[begin / RECORD_CHUNK_SIZE], view_mat, view_proj_mat);
+    } };
+    if (thread_pool) {
+        thread_pool->parallel_for(_packets.size(), RECORD_CHUNK_SIZE, job);
+    }
+    else {
+        for (std::size_t begin = 0; begin < _packets.size(); begin += RECORD_CHUNK_SIZE) {
+            job(begin, std::min(begin + RECORD_CHUNK_SIZE, _packets.size()), 0);
+        }
+    }
+
+    _stream->finish_writes();
+    for (std::size_t i = 0; i < chunk_count; ++i) {
+        _command_lists[i].replay();
+        _draw_calls += _command_lists[i].draw_calls();
+    }
+    _stream->end_frame();
+}
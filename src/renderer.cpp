@@ -1,10 +1,19 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include "renderer.hpp"
 #include "utils.hpp"
 #include "geometryObject.hpp"
 #include "matrix.hpp"
+#include "profiler.hpp"
+#include "replay.hpp"
 #include "sharedTypes.hpp"
 
+namespace {
+    // primitives per job of the model matrix pass
+    constexpr std::size_t MODEL_MAT_CHUNK_SIZE{ 256 };
+}
+
 my_gl::Program::Program(
     const char*                         vertex_shader_path,
     const char*                         fragment_shader_path,
@@ -16,6 +25,8 @@ my_gl::Program::Program(
     for (my_gl::Attribute& attrib : attribs) {
         this->set_attrib(attrib);
     }
+
+    bind_uniform_blocks();
 }
 
 // uniforms provided
@@ -35,6 +46,8 @@ my_gl::Program::Program(
     for (my_gl::Uniform& unif : unifs) {
         this->set_uniform_location(unif);
     }
+
+    bind_uniform_blocks();
 }
 
 my_gl::Program::~Program() {
@@ -80,6 +93,16 @@ void my_gl::Program::set_attrib(my_gl::Attribute& attr) {
     _attrs[attr.name] = std::move(attr);
 }
 
+void my_gl::Program::bind_uniform_blocks() const {
+    for (uint32_t binding = 0; binding < UniformBlock::COUNT; ++binding) {
+        const GLuint block_index{ glGetUniformBlockIndex(_program_id, UniformBlock::names[binding]) };
+        if (block_index == GL_INVALID_INDEX) {
+            continue;
+        }
+        glUniformBlockBinding(_program_id, block_index, binding);
+    }
+}
+
 void my_gl::Program::set_uniform_location(my_gl::Uniform& unif) {
     if (_program_id == 0) {
         std::cerr << "program is not initialized, uniform: " << unif.name << " can't be set\n";
@@ -102,61 +125,56 @@ void my_gl::Program::set_uniform_location(my_gl::Uniform& unif) {
     _unifs[unif.name] = std::move(unif);
 }
 
+// looks the name up on every call, for setup code, per frame values go through the uniform blocks
 void  my_gl::Program::set_uniform_value(std::string_view unif_name, int32_t val) const {
-    use();
     const Uniform* unif{ get_uniform(unif_name) };
     if (!unif) {
         return;
     }
-    glUniform1i(unif->location, val);
+    glProgramUniform1i(_program_id, unif->location, val);
 }
 
 void my_gl::Program::set_uniform_value(std::string_view unif_name, float val) const {
-    use();
     const Uniform* unif{ get_uniform(unif_name) };
     if (!unif) {
         return;
     }
-    glUniform1f(unif->location, val);
+    glProgramUniform1f(_program_id, unif->location, val);
 }
 
 void my_gl::Program::set_uniform_value(std::string_view unif_name, float val1, float val2, float val3) const {
-    use();
     const Uniform* unif{ get_uniform(unif_name) };
     if (!unif) {
         return;
     }
-    glUniform3f(unif->location, val1, val2, val3);
+    glProgramUniform3f(_program_id, unif->location, val1, val2, val3);
 }
 
 void my_gl::Program::set_uniform_value(std::string_view unif_name, const float* matrix_val) const {
-    use();
     const Uniform* unif{ get_uniform(unif_name) };
     if (!unif) {
         return;
     }
-    glUniformMatrix4fv(unif->location, 1, true, matrix_val);
+    glProgramUniformMatrix4fv(_program_id, unif->location, 1, true, matrix_val);
 }
 
 void my_gl::Program::set_uniform_value(std::string_view unif_name, const my_gl::math::Vec3<float>& vec3_val) const
 {
-    use();
     const Uniform* unif{ get_uniform(unif_name) };
     if (!unif) {
         return;
     }
     const float* vec_ptr = std::begin(vec3_val._data);
-    glUniform3fv(unif->location, 1, vec_ptr);
+    glProgramUniform3fv(_program_id, unif->location, 1, vec_ptr);
 }
 
 void my_gl::Program::set_uniform_value(std::string_view unif_name, const my_gl::math::Vec4<float>& vec4_val) const
 {
-    use();
     const Uniform* unif{ get_uniform(unif_name) };
     if (!unif) {
         return;
     }
-    glUniform4f(unif->location, vec4_val[0], vec4_val[1], vec4_val[2], vec4_val[3]);
+    glProgramUniform4f(_program_id, unif->location, vec4_val[0], vec4_val[1], vec4_val[2], vec4_val[3]);
 }
 
 const std::unordered_map<std::string_view, my_gl::Attribute>& my_gl::Program::get_attrs() const {
@@ -170,18 +188,22 @@ const std::unordered_map<std::string_view, my_gl::Uniform>& my_gl::Program::get_
 // VertexArray
 my_gl::VertexArray::VertexArray(
     const meshes::Mesh& mesh,
-    const Program&      program
+    const Program&      program,
+    GLenum              usage
 )
     : _mesh{ mesh }
+    , _usage{ usage }
 {
     init(program);
 }
 
 my_gl::VertexArray::VertexArray(
     meshes::Mesh&&  mesh,
-    const Program&  program
+    const Program&  program,
+    GLenum          usage
 )
     : _mesh{ std::move(mesh) }
+    , _usage{ usage }
 {
     init(program);
 }
@@ -195,16 +217,16 @@ my_gl::VertexArray::~VertexArray() {
 void my_gl::VertexArray::init(const Program& program) {
     // vao
     glCreateVertexArrays(1, &_vao_id);
-    glBindVertexArray(_vao_id);
+    globals::gl_state.bind_vertex_array(_vao_id);
 
     // vertex data
     glCreateBuffers(1, &_vbo_id);
-    glBindBuffer(GL_ARRAY_BUFFER, _vbo_id);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * _mesh.vertices.size(), _mesh.vertices.data(), GL_STATIC_DRAW);
+    globals::gl_state.bind_buffer(GL_ARRAY_BUFFER, _vbo_id);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * _mesh.vertices.size(), _mesh.vertices.data(), _usage);
 
     // indices
     glCreateBuffers(1, &_ibo_id);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo_id);
+    globals::gl_state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, _ibo_id);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t) * _mesh.indices.size(), _mesh.indices.data(), GL_STATIC_DRAW);
 
     const auto& attrs{ program.get_attrs() };
@@ -212,6 +234,11 @@ void my_gl::VertexArray::init(const Program& program) {
     for (auto it{ attrs.begin() }; it != attrs.end(); ++it) {
         const my_gl::Attribute& attr_ref{ it->second };
 
+        if (attr_ref.divisor != 0) {
+            init_instance_attrib(attr_ref);
+            continue;
+        }
+
         glEnableVertexAttribArray(attr_ref.location);
         glVertexAttribPointer(attr_ref.location, attr_ref.count, attr_ref.gl_type, false, attr_ref.byte_stride, reinterpret_cast<void*>(attr_ref.byte_offset));
 
@@ -221,9 +248,46 @@ void my_gl::VertexArray::init(const Program& program) {
     }
 
     // unbind
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    globals::gl_state.bind_vertex_array(0);
+    globals::gl_state.bind_buffer(GL_ARRAY_BUFFER, 0);
+}
+
+void my_gl::VertexArray::init_instance_attrib(const Attribute& attr) {
+    // instance buffer is attached when drawing, here only the format is set
+    const uint16_t locations{ static_cast<uint16_t>((attr.count + 3) / 4) };
+    for (uint16_t i = 0; i < locations; ++i) {
+        const uint32_t location{ static_cast<uint32_t>(attr.location) + i };
+        const int32_t count{ std::min(attr.count - i * 4, 4) };
+        const uint32_t byte_offset{ attr.byte_offset + i * 4 * 4u };
+
+        glEnableVertexArrayAttrib(_vao_id, location);
+        if (attr.gl_type == GL_FLOAT) {
+            glVertexArrayAttribFormat(_vao_id, location, count, attr.gl_type, false, byte_offset);
+        }
+        else {
+            glVertexArrayAttribIFormat(_vao_id, location, count, attr.gl_type, byte_offset);
+        }
+        glVertexArrayAttribBinding(_vao_id, location, INSTANCE_BINDING);
+    }
+    glVertexArrayBindingDivisor(_vao_id, INSTANCE_BINDING, attr.divisor);
+
+    _instance_stride = attr.byte_stride;
+    _is_instanced = true;
+
+#ifdef DEBUG
+    printf("info: instance attribute '%s' successfully initialized, location: '%d'\n", attr.name, attr.location);
+#endif
+}
+
+void my_gl::VertexArray::attach_instances(uint32_t buffer_id, std::size_t byte_offset) const {
+    glVertexArrayVertexBuffer(_vao_id, INSTANCE_BINDING, buffer_id, static_cast<GLintptr>(byte_offset), _instance_stride);
+}
+
+void my_gl::VertexArray::stream_vertices() const {
+    const GLsizeiptr byte_size{ static_cast<GLsizeiptr>(sizeof(float) * _mesh.vertices.size()) };
+    // orphan the old storage, so the driver doesn't wait for draws still reading it
+    glNamedBufferData(_vbo_id, byte_size, nullptr, _usage);
+    glNamedBufferSubData(_vbo_id, 0, byte_size, _mesh.vertices.data());
 }
 
 // Renderer
@@ -231,35 +295,133 @@ my_gl::Renderer::Renderer(
     std::span<my_gl::GeometryObjectComplex>     complex_objs,
     std::span<my_gl::GeometryObjectPrimitive>   primitives,
     math::Matrix44<float>&&                     view_mat,
-    math::Matrix44<float>&&                     proj_mat
+    math::Matrix44<float>&&                     proj_mat,
+    FixedTimestep                               physics_timestep
 )
     : _complex_objs{ complex_objs }
     , _primitives{ primitives }
     , _view_mat{ std::move(view_mat) }
     , _proj_mat{ std::move(proj_mat) }
-{}
-
-void my_gl::Renderer::render(my_gl::Duration_sec frame_time, float time_0to1) {
-    auto view_proj_mat{ _proj_mat * _view_mat };
+    , _simulation{ physics_timestep }
+    , _frame_data{ UniformBlock::FRAME_DATA, sizeof(FrameDataStd140), GL_DYNAMIC_DRAW }
+    , _material_table{ UniformBlock::MATERIAL_TABLE, sizeof(MaterialStd140) * Material::COUNT, GL_STATIC_DRAW }
+{
+    std::array<MaterialStd140, Material::COUNT> materials{};
+    for (std::size_t i = 0; i < materials.size(); ++i) {
+        const Material& material{ material_table[i] };
+        std::copy_n(material.ambient._data.begin(), 3, materials[i].ambient.begin());
+        std::copy_n(material.diffuse._data.begin(), 3, materials[i].diffuse.begin());
+        std::copy_n(material.specular._data.begin(), 3, materials[i].specular.begin());
+        materials[i].shininess = material.shininess;
+    }
+    _material_table.upload(materials);
 
     for (auto& complex_obj : _complex_objs) {
-        complex_obj.render(_view_mat, view_proj_mat, frame_time, time_0to1);
+        complex_obj.register_physics(_simulation._physics_world);
     }
 
     for (auto& primitive : _primitives) {
-        primitive.render(_view_mat, view_proj_mat, frame_time, time_0to1);
+        primitive.register_physics(_simulation._physics_world);
     }
+}
+
+void my_gl::Renderer::render(my_gl::Duration_sec frame_time) {
+    const ProfileScope profile_scope{ "render" };
+    _gpu_timer.begin_frame(globals::profiler);
+    using Clock = std::chrono::steady_clock;
+    auto lap_start{ Clock::now() };
+    auto lap{ [&lap_start](Duration_sec& phase) {
+        const auto now{ Clock::now() };
+        phase += now - lap_start;
+        lap_start = now;
+    } };
+
+    _simulation.advance(frame_time);
+    lap(_timings.simulate);
+
+    compute_transforms(_simulation._physics_world, _simulation.alpha());
+    lap(_timings.transforms);
+
+    const auto view_proj_mat{ _proj_mat * _view_mat };
+    const std::size_t visible_count{ cull(view_proj_mat) };
+    lap(_timings.cull);
+
+    build_draw_list();
+    lap(_timings.build_draw_list);
+
+    submit(view_proj_mat);
+    lap(_timings.submit);
+
+    ++_timings.frames;
+    _frame_stats = FrameStats{
+        .primitives = static_cast<uint32_t>(_frame_primitives.size()),
+        .culled = static_cast<uint32_t>(_frame_primitives.size() - visible_count),
+        .draw_calls = _render_queue.draw_calls(),
+    };
+}
 
-    for (uint32_t i = 0; i < _primitives.size() - 1; ++i) {
-        for (uint32_t j = i + 1; j < _primitives.size(); ++j) {
-            if (_primitives[i].check_collision(_primitives[j])) {
-                _primitives[i].handle_collision(_primitives[j]);
-            }
+void my_gl::Renderer::compute_transforms(const PhysicsWorld& physics_world, float physics_alpha) {
+    const ProfileScope profile_scope{ "transforms" };
+    _frame_primitives.clear();
+    for (auto& complex_obj : _complex_objs) {
+        for (auto& primitive : complex_obj.primitives()) {
+            _frame_primitives.push_back(&primitive);
         }
     }
+    for (auto& primitive : _primitives) {
+        _frame_primitives.push_back(&primitive);
+    }
+
+    // copied primitives share their transform data, so animations step here on one thread
+    // and workers only read them
+    for (GeometryObjectPrimitive* primitive : _frame_primitives) {
+        primitive->update_anims();
+    }
+
+    _frame_bounds.resize(_frame_primitives.size());
+    _simulation._thread_pool.parallel_for(_frame_primitives.size(), MODEL_MAT_CHUNK_SIZE, [&](std::size_t begin, std::size_t end, uint32_t) {
+        for (std::size_t i = begin; i < end; ++i) {
+            _frame_primitives[i]->calc_model_mat_frame(physics_world, physics_alpha);
+            _frame_bounds.set(i, _frame_primitives[i]->world_bounds());
+        }
+    });
+}
+
+std::size_t my_gl::Renderer::cull(const math::Matrix44<float>& view_proj_mat) {
+    const ProfileScope profile_scope{ "cull" };
+    return Frustum::from_view_proj(view_proj_mat).cull(_frame_bounds, _frame_visible);
+}
+
+void my_gl::Renderer::build_draw_list() {
+    const ProfileScope profile_scope{ "build draw list" };
+    _render_queue.clear();
+    for (std::size_t i = 0; i < _frame_primitives.size(); ++i) {
+        if (_frame_visible[i]) {
+            _frame_primitives[i]->emit(_render_queue, _view_mat);
+        }
+    }
+    _render_queue.sort();
+}
+
+void my_gl::Renderer::submit(const math::Matrix44<float>& view_proj_mat) {
+    const ProfileScope profile_scope{ "submit" };
+    const GpuScope gpu_scope{ _gpu_timer, "submit" };
+    FrameDataStd140 frame_data{};
+    std::copy_n(_view_mat.data(), 16, frame_data.view_mat.begin());
+    std::copy_n(_proj_mat.data(), 16, frame_data.proj_mat.begin());
+    std::copy_n(view_proj_mat.data(), 16, frame_data.view_proj_mat.begin());
+    std::copy_n(_view_pos._data.begin(), 3, frame_data.view_pos.begin());
+    std::copy_n(_light.position._data.begin(), 3, frame_data.light_position.begin());
+    std::copy_n(_light.ambient._data.begin(), 3, frame_data.light_ambient.begin());
+    std::copy_n(_light.diffuse._data.begin(), 3, frame_data.light_diffuse.begin());
+    std::copy_n(_light.specular._data.begin(), 3, frame_data.light_specular.begin());
+    _frame_data.upload(frame_data);
+
+    _render_queue.execute(_view_mat, view_proj_mat, &_simulation._thread_pool);
 }
 
 void my_gl::Renderer::update_time(Duration_sec frame_duration) {
+    const ProfileScope profile_scope{ "update" };
     _rendering_time_curr += frame_duration;
 
     for (auto& complex_obj : _complex_objs) {
@@ -271,6 +433,23 @@ void my_gl::Renderer::update_time(Duration_sec frame_duration) {
     }
 }
 
+uint64_t my_gl::Renderer::transforms_checksum() const {
+    uint64_t hash{ FNV_OFFSET_BASIS };
+
+    for (const auto& complex_obj : _complex_objs) {
+        hash = complex_obj.hash_transforms(hash);
+    }
+    for (const auto& primitive : _primitives) {
+        hash = primitive.hash_transforms(hash);
+    }
+    for (auto& cloth : _simulation._cloths) {
+        const meshes::Mesh mesh{ cloth.mesh() };
+        hash = fnv1a(mesh.vertices.data(), sizeof(float) * mesh.vertices.size(), hash);
+    }
+
+    return hash;
+}
+
 my_gl::Duration_sec my_gl::Renderer::get_curr_rendering_duration() const {
     return _rendering_time_curr - _rendering_time_start;
 }
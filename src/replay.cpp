@@ -0,0 +1,148 @@
+#include <fstream>
+#include <iostream>
+#include "replay.hpp"
+
+namespace {
+    constexpr uint32_t REPLAY_MAGIC{ 0x52474c4d }; // "MLGR" read as little endian bytes
+    constexpr uint32_t REPLAY_VERSION{ 1 };
+    constexpr uint64_t FNV_PRIME{ 1099511628211ull };
+    // as written by save, field by field
+    constexpr std::size_t FRAME_FILE_SIZE{ sizeof(float) + sizeof(uint32_t) * 2 + sizeof(uint64_t) };
+    constexpr std::size_t EVENT_FILE_SIZE{ sizeof(my_gl::InputEvent::Type) + sizeof(int32_t) * 2 + sizeof(float) * 2 };
+
+    template<typename T>
+    void write_value(std::ofstream& file, const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    bool read_value(std::ifstream& file, T& value) {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+}
+
+uint64_t my_gl::fnv1a(const void* data, std::size_t byte_size, uint64_t hash) {
+    const auto* bytes{ static_cast<const unsigned char*>(data) };
+    for (std::size_t i = 0; i < byte_size; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+void my_gl::ReplayLog::record_event(const InputEvent& event) {
+    _events.push_back(event);
+}
+
+void my_gl::ReplayLog::record_frame(Duration_sec frame_duration, uint64_t checksum) {
+    const uint32_t first_event{ _frames.empty() ? 0 : _frames.back().first_event + _frames.back().event_count };
+    _frames.push_back(Frame{
+        .duration = frame_duration.count(),
+        .first_event = first_event,
+        .event_count = static_cast<uint32_t>(_events.size()) - first_event,
+        .checksum = checksum,
+    });
+}
+
+void my_gl::ReplayLog::clear() {
+    _frames.clear();
+    _events.clear();
+}
+
+std::span<const my_gl::InputEvent> my_gl::ReplayLog::events(std::size_t index) const {
+    const Frame& frame{ _frames[index] };
+    return std::span<const InputEvent>{ _events }.subspan(frame.first_event, frame.event_count);
+}
+
+// fields are written one by one, so padding never ends up in the file
+bool my_gl::ReplayLog::save(const char* path) const {
+    std::ofstream file{ path, std::ios_base::binary };
+    if (!file.is_open()) {
+        std::cerr << "replay log can't be written to " << path << '\n';
+        return false;
+    }
+
+    write_value(file, REPLAY_MAGIC);
+    write_value(file, REPLAY_VERSION);
+    write_value(file, static_cast<uint32_t>(_frames.size()));
+    write_value(file, static_cast<uint32_t>(_events.size()));
+
+    for (const Frame& frame : _frames) {
+        write_value(file, frame.duration);
+        write_value(file, frame.first_event);
+        write_value(file, frame.event_count);
+        write_value(file, frame.checksum);
+    }
+    for (const InputEvent& event : _events) {
+        write_value(file, event.type);
+        write_value(file, event.key);
+        write_value(file, event.action);
+        write_value(file, event.x);
+        write_value(file, event.y);
+    }
+
+    return static_cast<bool>(file);
+}
+
+bool my_gl::ReplayLog::load(const char* path) {
+    clear();
+
+    std::ifstream file{ path, std::ios_base::binary };
+    if (!file.is_open()) {
+        std::cerr << "replay log can't be read from " << path << '\n';
+        return false;
+    }
+
+    uint32_t magic{ 0 };
+    uint32_t version{ 0 };
+    uint32_t frame_count{ 0 };
+    uint32_t event_count{ 0 };
+    if (!read_value(file, magic) || !read_value(file, version) || magic != REPLAY_MAGIC || version != REPLAY_VERSION) {
+        std::cerr << path << " is not a replay log of version " << REPLAY_VERSION << '\n';
+        return false;
+    }
+    if (!read_value(file, frame_count) || !read_value(file, event_count)) {
+        std::cerr << "replay log " << path << " is truncated\n";
+        return false;
+    }
+
+    // counts come from the file, don't allocate more than the rest of it can fill
+    const std::streampos data_start{ file.tellg() };
+    file.seekg(0, std::ios_base::end);
+    const uint64_t data_size{ static_cast<uint64_t>(file.tellg() - data_start) };
+    file.seekg(data_start);
+    if (uint64_t{ frame_count } * FRAME_FILE_SIZE + uint64_t{ event_count } * EVENT_FILE_SIZE > data_size) {
+        std::cerr << "replay log " << path << " is truncated or corrupted\n";
+        return false;
+    }
+
+    _frames.resize(frame_count);
+    _events.resize(event_count);
+    bool is_read{ true };
+    for (Frame& frame : _frames) {
+        is_read = is_read
+            && read_value(file, frame.duration)
+            && read_value(file, frame.first_event)
+            && read_value(file, frame.event_count)
+            && read_value(file, frame.checksum)
+            // in this order, so the sum can't wrap
+            && frame.first_event <= event_count
+            && frame.event_count <= event_count - frame.first_event;
+    }
+    for (InputEvent& event : _events) {
+        is_read = is_read
+            && read_value(file, event.type)
+            && read_value(file, event.key)
+            && read_value(file, event.action)
+            && read_value(file, event.x)
+            && read_value(file, event.y);
+    }
+
+    if (!is_read) {
+        std::cerr << "replay log " << path << " is truncated or corrupted\n";
+        clear();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <cmath>
+#include "physicsWorld.hpp"
+#include "profiler.hpp"
+#include "sceneQuery.hpp"
+#include "threadPool.hpp"
+
+namespace {
+    using my_gl::AABB;
+    using my_gl::math::Vec3;
+
+    constexpr uint32_t MAX_LEAF_ITEMS{ 4 };
+    // enough for a tree of any size built by median splits
+    constexpr uint32_t MAX_STACK_DEPTH{ 64 };
+    constexpr std::size_t RAYS_PER_TASK{ 64 };
+    constexpr uint32_t INVALID_ITEM{ std::numeric_limits<uint32_t>::max() };
+
+    // distance along the ray where it enters the box, negative if it misses
+    float ray_box(const Vec3<float>& origin, const Vec3<float>& inv_direction, const AABB& box, float max_distance) {
+        float enter{ 0.0f };
+        float exit{ max_distance };
+
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            float near{ (box.min[axis] - origin[axis]) * inv_direction[axis] };
+            float far{ (box.max[axis] - origin[axis]) * inv_direction[axis] };
+            if (near > far) {
+                std::swap(near, far);
+            }
+            enter = std::max(enter, near);
+            exit = std::min(exit, far);
+            if (enter > exit) {
+                return -1.0f;
+            }
+        }
+
+        return enter;
+    }
+
+    float distance_sq(const Vec3<float>& point, const AABB& box) {
+        float res{ 0.0f };
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            const float delta{ std::max({ box.min[axis] - point[axis], 0.0f, point[axis] - box.max[axis] }) };
+            res += delta * delta;
+        }
+        return res;
+    }
+}
+
+void my_gl::SceneQuery::build(const PhysicsWorld& world) {
+    const ProfileScope profile_scope{ "scene query" };
+    _nodes.clear();
+    _items.clear();
+
+    for (BodyId body = 0; body < world.size(); ++body) {
+        const AABB bounds{ world.world_bounds(body) };
+        // bodies without bounds can't be hit
+        if (bounds.min[0] <= bounds.max[0]) {
+            _items.push_back(Item{ bounds, body });
+        }
+    }
+
+    if (_items.empty()) {
+        return;
+    }
+
+    // a binary tree with leaves of at least one item has less than 2n nodes
+    _nodes.reserve(_items.size() * 2);
+    _nodes.push_back(Node{});
+    build_node(0, 0, static_cast<uint32_t>(_items.size()));
+}
+
+void my_gl::SceneQuery::build_node(uint32_t node_index, uint32_t first, uint32_t item_count) {
+    AABB bounds;
+    AABB centers;
+    for (uint32_t i = first; i < first + item_count; ++i) {
+        bounds.expand(_items[i].bounds.min);
+        bounds.expand(_items[i].bounds.max);
+        centers.expand(_items[i].bounds.center());
+    }
+    _nodes[node_index] = Node{ .bounds = bounds, .first = first, .item_count = item_count };
+
+    if (item_count <= MAX_LEAF_ITEMS) {
+        return;
+    }
+
+    // median split along the longest axis of centers
+    const Vec3<float> extent{ centers.max - centers.min };
+    const uint32_t axis{ extent[0] >= extent[1] && extent[0] >= extent[2] ? 0u : extent[1] >= extent[2] ? 1u : 2u };
+    const uint32_t half{ item_count / 2 };
+    const auto items_begin{ _items.begin() + first };
+
+    std::nth_element(items_begin, items_begin + half, items_begin + item_count, [axis](const Item& lhs, const Item& rhs) {
+        const float lhs_center{ lhs.bounds.min[axis] + lhs.bounds.max[axis] };
+        const float rhs_center{ rhs.bounds.min[axis] + rhs.bounds.max[axis] };
+        return lhs_center < rhs_center || (lhs_center == rhs_center && lhs.body < rhs.body);
+    });
+
+    // children are next to each other
+    const uint32_t left{ static_cast<uint32_t>(_nodes.size()) };
+    _nodes.push_back(Node{});
+    _nodes.push_back(Node{});
+    _nodes[node_index].first = left;
+    _nodes[node_index].item_count = 0;
+
+    build_node(left, first, half);
+    build_node(left + 1, first + half, item_count - half);
+}
+
+bool my_gl::SceneQuery::raycast(const Ray& ray, RayHit& hit) const {
+    hit = RayHit{};
+    if (_nodes.empty()) {
+        return false;
+    }
+
+    // division by zero gives infinity, slab test handles it
+    const Vec3<float> inv_direction{ 1.0f / ray.direction[0], 1.0f / ray.direction[1], 1.0f / ray.direction[2] };
+    float closest{ ray.max_distance };
+    uint32_t hit_item{ INVALID_ITEM };
+
+    // nodes the ray enters, with the distance it enters them at
+    struct StackEntry {
+        uint32_t    node;
+        float       enter;
+    };
+    StackEntry stack[MAX_STACK_DEPTH];
+    uint32_t stack_size{ 0 };
+    const float root_enter{ ray_box(ray.origin, inv_direction, _nodes[0].bounds, closest) };
+    if (root_enter >= 0.0f) {
+        stack[stack_size++] = StackEntry{ 0, root_enter };
+    }
+
+    while (stack_size > 0) {
+        const StackEntry entry{ stack[--stack_size] };
+        // a hit found since the push can be closer than the whole node
+        if (entry.enter > closest) {
+            continue;
+        }
+
+        const Node& node{ _nodes[entry.node] };
+        if (node.item_count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.item_count; ++i) {
+                const float enter{ ray_box(ray.origin, inv_direction, _items[i].bounds, closest) };
+                if (enter >= 0.0f && (enter < closest || hit_item == INVALID_ITEM)) {
+                    closest = enter;
+                    hit_item = i;
+                }
+            }
+            continue;
+        }
+
+        // closer child goes on top, so its hits shrink closest before the other one is tested,
+        // children the ray misses aren't pushed at all
+        StackEntry closer{ node.first, ray_box(ray.origin, inv_direction, _nodes[node.first].bounds, closest) };
+        StackEntry further{ node.first + 1, ray_box(ray.origin, inv_direction, _nodes[node.first + 1].bounds, closest) };
+        if (further.enter >= 0.0f && (closer.enter < 0.0f || further.enter < closer.enter)) {
+            std::swap(closer, further);
+        }
+        if (further.enter >= 0.0f) {
+            stack[stack_size++] = further;
+        }
+        if (closer.enter >= 0.0f) {
+            stack[stack_size++] = closer;
+        }
+    }
+
+    if (hit_item == INVALID_ITEM) {
+        return false;
+    }
+
+    const AABB& box{ _items[hit_item].bounds };
+    hit.body = _items[hit_item].body;
+    hit.distance = closest;
+    hit.point = ray.origin + ray.direction * closest;
+
+    // normal of the face closest to the point, ray starting inside gets the opposite direction
+    hit.normal = ray.direction * -1.0f;
+    if (closest > 0.0f) {
+        float best{ std::numeric_limits<float>::max() };
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            const float to_min{ std::abs(hit.point[axis] - box.min[axis]) };
+            const float to_max{ std::abs(hit.point[axis] - box.max[axis]) };
+            if (std::min(to_min, to_max) < best) {
+                best = std::min(to_min, to_max);
+                hit.normal = math::Vec3<float>{ 0.0f, 0.0f, 0.0f };
+                hit.normal[axis] = to_min < to_max ? -1.0f : 1.0f;
+            }
+        }
+    }
+
+    return true;
+}
+
+void my_gl::SceneQuery::raycast_batch(std::span<const Ray> rays, std::span<RayHit> hits, ThreadPool* thread_pool) const {
+    const std::size_t count{ std::min(rays.size(), hits.size()) };
+    auto job{ [&](std::size_t begin, std::size_t end, uint32_t) {
+        for (std::size_t i = begin; i < end; ++i) {
+            raycast(rays[i], hits[i]);
+        }
+    } };
+
+    if (thread_pool) {
+        thread_pool->parallel_for(count, RAYS_PER_TASK, job);
+    }
+    else {
+        job(0, count, 0);
+    }
+}
+
+void my_gl::SceneQuery::overlap_sphere(const math::Vec3<float>& center, float radius, std::vector<BodyId>& out) const {
+    if (_nodes.empty()) {
+        return;
+    }
+
+    const float radius_sq{ radius * radius };
+    uint32_t stack[MAX_STACK_DEPTH];
+    uint32_t stack_size{ 0 };
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const Node& node{ _nodes[stack[--stack_size]] };
+        if (distance_sq(center, node.bounds) > radius_sq) {
+            continue;
+        }
+
+        if (node.item_count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.item_count; ++i) {
+                if (distance_sq(center, _items[i].bounds) <= radius_sq) {
+                    out.push_back(_items[i].body);
+                }
+            }
+            continue;
+        }
+
+        stack[stack_size++] = node.first;
+        stack[stack_size++] = node.first + 1;
+    }
+}
+
+void my_gl::SceneQuery::overlap_box(const AABB& box, std::vector<BodyId>& out) const {
+    if (_nodes.empty()) {
+        return;
+    }
+
+    uint32_t stack[MAX_STACK_DEPTH];
+    uint32_t stack_size{ 0 };
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const Node& node{ _nodes[stack[--stack_size]] };
+        if (!node.bounds.overlaps(box)) {
+            continue;
+        }
+
+        if (node.item_count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.item_count; ++i) {
+                if (_items[i].bounds.overlaps(box)) {
+                    out.push_back(_items[i].body);
+                }
+            }
+            continue;
+        }
+
+        stack[stack_size++] = node.first;
+        stack[stack_size++] = node.first + 1;
+    }
+}
+
+void my_gl::SceneQuery::nearest(const math::Vec3<float>& point, uint32_t count, std::vector<BodyId>& out) const {
+    out.clear();
+    if (_nodes.empty() || count == 0) {
+        return;
+    }
+
+    // current best candidates, sorted by distance, worst one is the pruning radius,
+    // kept per thread so many queries a frame don't allocate
+    thread_local std::vector<std::pair<float, BodyId>> best;
+    best.clear();
+    best.reserve(count + 1);
+    auto worst{ [&] { return best.size() < count ? std::numeric_limits<float>::max() : best.back().first; } };
+
+    uint32_t stack[MAX_STACK_DEPTH];
+    uint32_t stack_size{ 0 };
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const Node& node{ _nodes[stack[--stack_size]] };
+        if (distance_sq(point, node.bounds) > worst()) {
+            continue;
+        }
+
+        if (node.item_count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.item_count; ++i) {
+                const float dist_sq{ distance_sq(point, _items[i].bounds) };
+                if (dist_sq >= worst()) {
+                    continue;
+                }
+                const std::pair<float, BodyId> candidate{ dist_sq, _items[i].body };
+                best.insert(std::upper_bound(best.begin(), best.end(), candidate), candidate);
+                if (best.size() > count) {
+                    best.pop_back();
+                }
+            }
+            continue;
+        }
+
+        // closer child goes on top, so it shrinks the radius before the other one is tested
+        const uint32_t left{ node.first };
+        const uint32_t right{ node.first + 1 };
+        if (distance_sq(point, _nodes[left].bounds) < distance_sq(point, _nodes[right].bounds)) {
+            stack[stack_size++] = right;
+            stack[stack_size++] = left;
+        }
+        else {
+            stack[stack_size++] = left;
+            stack[stack_size++] = right;
+        }
+    }
+
+    for (const auto& [dist_sq, body] : best) {
+        out.push_back(body);
+    }
+}
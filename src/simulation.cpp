@@ -0,0 +1,81 @@
+#include <chrono>
+#include "profiler.hpp"
+#include "simulation.hpp"
+
+my_gl::Simulation::Simulation(FixedTimestep timestep, uint32_t thread_count)
+    : _thread_pool{ thread_count }
+    , _timestep{ timestep }
+{
+    _physics_world.set_thread_pool(&_thread_pool);
+}
+
+uint32_t my_gl::Simulation::advance(Duration_sec frame_time) {
+    const ProfileScope profile_scope{ "simulation" };
+    using Clock = std::chrono::steady_clock;
+    auto lap_start{ Clock::now() };
+    auto lap{ [&lap_start](Duration_sec& phase) {
+        const auto now{ Clock::now() };
+        phase += now - lap_start;
+        lap_start = now;
+    } };
+
+    // physics runs at its own fixed rate, independent from the frame rate
+    const uint32_t steps{ _timestep.advance(frame_time) };
+    _collision_events.clear();
+    for (uint32_t i = 0; i < steps; ++i) {
+        _physics_world.step(_timestep.step_duration());
+        // before the next step can overwrite them
+        drain_collision_events();
+        lap(_timings.physics);
+        step_cloths(_cloths, _timestep.step_duration(), &_thread_pool);
+        lap(_timings.cloths);
+    }
+
+    if (steps > 0) {
+        for (auto& cloth : _cloths) {
+            cloth.update_vertices();
+        }
+        lap(_timings.cloths);
+    }
+
+    for (auto& animation : _animations) {
+        animation.update();
+        animation.update_time(frame_time);
+    }
+    lap(_timings.animations);
+
+    ++_timings.frames;
+    return steps;
+}
+
+void my_gl::Simulation::step(float step_duration) {
+    _collision_events.clear();
+    _physics_world.step(step_duration);
+    drain_collision_events();
+    step_cloths(_cloths, step_duration, &_thread_pool);
+}
+
+const my_gl::SceneQuery& my_gl::Simulation::scene_query() {
+    // queries see bodies where the last step left them, steps of a sleeping world keep the old tree
+    if (_scene_query_dirty || _physics_world.moves() != _scene_query_moves) {
+        const ProfileScope profile_scope{ "scene query" };
+        const auto start{ std::chrono::steady_clock::now() };
+        _scene_query.build(_physics_world);
+        _scene_query_dirty = false;
+        _scene_query_moves = _physics_world.moves();
+        _timings.scene_query += std::chrono::steady_clock::now() - start;
+    }
+    return _scene_query;
+}
+
+void my_gl::Simulation::drain_collision_events() {
+    CollisionEvent event;
+    while (_physics_world._events.pop(event)) {
+        _collision_events.push_back(event);
+    }
+}
+
+void my_gl::Simulation::reset_timings() {
+    _timings = SimulationTimings{};
+    _physics_world._timings = PhysicsTimings{};
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include "streamBuffer.hpp"
+
+namespace {
+    constexpr GLbitfield PERSISTENT_FLAGS{ GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT };
+    // a second is long enough to mean something went wrong
+    constexpr GLuint64 FENCE_TIMEOUT_NS{ 1'000'000'000 };
+    // keeps region starts aligned for any uniform buffer offset alignment seen in practice
+    constexpr std::size_t REGION_BYTE_ALIGNMENT{ 256 };
+}
+
+my_gl::StreamBuffer::StreamBuffer(std::size_t region_byte_size) {
+    create(region_byte_size);
+}
+
+my_gl::StreamBuffer::~StreamBuffer() {
+    destroy();
+}
+
+void my_gl::StreamBuffer::create(std::size_t region_byte_size) {
+    _region_byte_size = (region_byte_size + REGION_BYTE_ALIGNMENT - 1) & ~(REGION_BYTE_ALIGNMENT - 1);
+    _is_persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    glCreateBuffers(1, &_id);
+
+    if (_is_persistent) {
+        const GLsizeiptr byte_size{ static_cast<GLsizeiptr>(_region_byte_size * REGIONS_COUNT) };
+        glNamedBufferStorage(_id, byte_size, nullptr, PERSISTENT_FLAGS);
+        _mapped = static_cast<std::byte*>(glMapNamedBufferRange(_id, 0, byte_size, PERSISTENT_FLAGS));
+        if (!_mapped) {
+            std::cerr << "stream buffer: persistent mapping failed, falling back to orphaning\n";
+            glDeleteBuffers(1, &_id);
+            glCreateBuffers(1, &_id);
+            _is_persistent = false;
+        }
+    }
+    if (!_is_persistent) {
+        glNamedBufferData(_id, static_cast<GLsizeiptr>(_region_byte_size), nullptr, GL_STREAM_DRAW);
+    }
+}
+
+void my_gl::StreamBuffer::destroy() {
+    for (GLsync& fence : _fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (_is_persistent && _mapped) {
+        glUnmapNamedBuffer(_id);
+    }
+    _mapped = nullptr;
+    glDeleteBuffers(1, &_id);
+    _id = 0;
+}
+
+void my_gl::StreamBuffer::begin_frame(std::size_t frame_byte_size) {
+    if (frame_byte_size > _region_byte_size) {
+        // gl keeps the old storage until draws reading it are done
+        destroy();
+        create(std::max(frame_byte_size, _region_byte_size * 2));
+    }
+
+    if (_is_persistent) {
+        _region = (_region + 1) % REGIONS_COUNT;
+        GLsync& fence{ _fences[_region] };
+        if (fence) {
+            GLenum result{ glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS) };
+            while (result == GL_TIMEOUT_EXPIRED) {
+                std::cerr << "stream buffer: still waiting for the gpu to release region " << _region << '\n';
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+            }
+            assert(result != GL_WAIT_FAILED && "waiting on a stream buffer fence failed");
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+        _head = _region * _region_byte_size;
+    }
+    else {
+        // invalidating the whole buffer orphans it, the draws of the last frame keep the old storage
+        _mapped = static_cast<std::byte*>(glMapNamedBufferRange(
+            _id, 0, static_cast<GLsizeiptr>(_region_byte_size), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT
+        ));
+        _head = 0;
+    }
+    _end = _head + _region_byte_size;
+}
+
+my_gl::StreamAllocation my_gl::StreamBuffer::allocate(std::size_t byte_size, std::size_t byte_alignment) {
+    const std::size_t byte_offset{ (_head + byte_alignment - 1) & ~(byte_alignment - 1) };
+    assert(byte_offset + byte_size <= _end && "stream buffer frame was begun too small");
+    _head = byte_offset + byte_size;
+    return StreamAllocation{ .data = _mapped + byte_offset, .byte_offset = byte_offset };
+}
+
+void my_gl::StreamBuffer::finish_writes() {
+    // coherent mapping makes writes visible by itself
+    if (!_is_persistent) {
+        glUnmapNamedBuffer(_id);
+        _mapped = nullptr;
+    }
+}
+
+void my_gl::StreamBuffer::end_frame() {
+    if (_is_persistent) {
+        _fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
@@ -1,7 +1,9 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <iostream>
 #include "texture.hpp"
+#include "glState.hpp"
 #include "renderer.hpp"
+#include "trace.hpp"
 
 namespace my_gl {
     Texture::Texture(
@@ -18,6 +20,7 @@ namespace my_gl {
         : _texture_unit{ texture_unit }
         , _3d{ is_3d }
     {
+        MY_GL_TRACE_SCOPE("texture load");
         glGenTextures(1, &_id);
 
         // set texture unit
@@ -62,21 +65,10 @@ namespace my_gl {
     }
 
     void Texture::bind() const {
-        glActiveTexture(_texture_unit);
-        if (!_3d) {
-            glBindTexture(GL_TEXTURE_2D, _id);
-        }
-        else {
-            glBindTexture(GL_TEXTURE_3D, _id);
-        }
+        globals::gl_state.bind_texture(_texture_unit - GL_TEXTURE0, _3d ? GL_TEXTURE_3D : GL_TEXTURE_2D, _id);
     }
 
     void Texture::un_bind() const {
-        if (!_3d) {
-            glBindTexture(GL_TEXTURE_2D, 0);
-        }
-        else {
-            glBindTexture(GL_TEXTURE_3D, 0);
-        }
+        globals::gl_state.bind_texture(_texture_unit - GL_TEXTURE0, _3d ? GL_TEXTURE_3D : GL_TEXTURE_2D, 0);
     }
 }
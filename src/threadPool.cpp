@@ -0,0 +1,92 @@
+#include <algorithm>
+#include "threadPool.hpp"
+#include "trace.hpp"
+
+my_gl::ThreadPool::ThreadPool(uint32_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    _workers.reserve(thread_count - 1);
+    for (uint32_t worker = 1; worker < thread_count; ++worker) {
+        _workers.emplace_back(&ThreadPool::worker_loop, this, worker);
+    }
+}
+
+my_gl::ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{ _mutex };
+        _stop = true;
+    }
+    _start_cv.notify_all();
+
+    for (std::thread& thread : _workers) {
+        thread.join();
+    }
+}
+
+void my_gl::ThreadPool::parallel_for(std::size_t count, std::size_t chunk_size, const Job& job) {
+    if (count == 0) {
+        return;
+    }
+    chunk_size = std::max(chunk_size, std::size_t{ 1 });
+
+    // not worth waking anybody up
+    if (_workers.empty() || count <= chunk_size) {
+        for (std::size_t begin = 0; begin < count; begin += chunk_size) {
+            job(begin, std::min(begin + chunk_size, count), 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock{ _mutex };
+        _job = &job;
+        _count = count;
+        _chunk_size = chunk_size;
+        _next_chunk.store(0, std::memory_order_relaxed);
+        _busy_workers = static_cast<uint32_t>(_workers.size());
+        ++_generation;
+    }
+    _start_cv.notify_all();
+
+    run_chunks(0);
+
+    std::unique_lock lock{ _mutex };
+    _done_cv.wait(lock, [this] { return _busy_workers == 0; });
+    _job = nullptr;
+}
+
+void my_gl::ThreadPool::worker_loop(uint32_t worker) {
+    MY_GL_TRACE_THREAD_NAME("worker");
+    uint64_t seen_generation{ 0 };
+
+    while (true) {
+        {
+            std::unique_lock lock{ _mutex };
+            _start_cv.wait(lock, [&] { return _stop || _generation != seen_generation; });
+            if (_stop) {
+                return;
+            }
+            seen_generation = _generation;
+        }
+
+        run_chunks(worker);
+
+        std::lock_guard lock{ _mutex };
+        if (--_busy_workers == 0) {
+            _done_cv.notify_one();
+        }
+    }
+}
+
+void my_gl::ThreadPool::run_chunks(uint32_t worker) {
+    MY_GL_TRACE_SCOPE("parallel for");
+    while (true) {
+        const std::size_t begin{ _next_chunk.fetch_add(1, std::memory_order_relaxed) * _chunk_size };
+        if (begin >= _count) {
+            return;
+        }
+        (*_job)(begin, std::min(begin + _chunk_size, _count), worker);
+    }
+}
@@ -0,0 +1,174 @@
+#include "trace.hpp"
+
+#ifdef MY_GL_TRACING
+#include <fstream>
+#include <iostream>
+
+namespace my_gl {
+    namespace globals {
+        TraceRecorder tracer;
+    }
+}
+
+my_gl::TraceBuffer::TraceBuffer(uint32_t thread_id)
+    : _thread_id{ thread_id }
+    , _events(CAPACITY)
+{}
+
+void my_gl::TraceBuffer::push(const char* name, uint64_t timestamp_ns, bool is_begin) {
+    const uint64_t head{ _head.load(std::memory_order_relaxed) };
+    if (head - _tail.load(std::memory_order_acquire) >= CAPACITY) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    _events[head % CAPACITY] = TraceEvent{ .name = name, .timestamp_ns = timestamp_ns, .is_begin = is_begin };
+    // publishes the event to the writer
+    _head.store(head + 1, std::memory_order_release);
+}
+
+void my_gl::TraceBuffer::drain(std::vector<TraceEvent>& out) {
+    const uint64_t head{ _head.load(std::memory_order_acquire) };
+    const uint64_t tail{ _tail.load(std::memory_order_relaxed) };
+    for (uint64_t i = tail; i < head; ++i) {
+        out.push_back(_events[i % CAPACITY]);
+    }
+    // hands the slots back to the owning thread
+    _tail.store(head, std::memory_order_release);
+}
+
+my_gl::TraceRecorder::TraceRecorder()
+    : _start{ std::chrono::steady_clock::now() }
+{}
+
+my_gl::TraceRecorder::~TraceRecorder() {
+    if (_writer.joinable()) {
+        _writer.join();
+    }
+}
+
+void my_gl::TraceRecorder::begin(const char* name) {
+    if (_enabled) {
+        thread_buffer().push(name, now_ns(), true);
+    }
+}
+
+void my_gl::TraceRecorder::end() {
+    if (_enabled) {
+        thread_buffer().push(nullptr, now_ns(), false);
+    }
+}
+
+void my_gl::TraceRecorder::set_thread_name(const char* name) {
+    if (_enabled) {
+        thread_buffer()._thread_name.store(name, std::memory_order_relaxed);
+    }
+}
+
+void my_gl::TraceRecorder::end_frame() {
+    ++_frames;
+    if (_enabled && _flush_after_frames > 0 && _frames % _flush_after_frames == 0) {
+        request_flush();
+    }
+}
+
+void my_gl::TraceRecorder::request_flush() {
+    if (!_enabled || _is_writing.exchange(true)) {
+        return;
+    }
+    if (_writer.joinable()) {
+        _writer.join();
+    }
+
+    _writer = std::thread{ &TraceRecorder::write, this, buffers(), _path + '_' + std::to_string(_flushes++) + ".json" };
+}
+
+void my_gl::TraceRecorder::flush() {
+    if (!_enabled) {
+        return;
+    }
+    // a periodic flush may still be writing, request_flush would skip this one
+    if (_writer.joinable()) {
+        _writer.join();
+    }
+
+    _is_writing.store(true);
+    write(buffers(), _path + '_' + std::to_string(_flushes++) + ".json");
+}
+
+std::vector<my_gl::TraceBuffer*> my_gl::TraceRecorder::buffers() {
+    std::lock_guard lock{ _buffers_mutex };
+    std::vector<TraceBuffer*> buffers;
+    for (const auto& buffer : _buffers) {
+        buffers.push_back(buffer.get());
+    }
+    return buffers;
+}
+
+my_gl::TraceBuffer& my_gl::TraceRecorder::thread_buffer() {
+    // owned by the recorder, events of a thread that exited can still be written
+    thread_local TraceBuffer* buffer{ nullptr };
+    if (!buffer) {
+        std::lock_guard lock{ _buffers_mutex };
+        _buffers.push_back(std::make_unique<TraceBuffer>(static_cast<uint32_t>(_buffers.size())));
+        buffer = _buffers.back().get();
+    }
+    return *buffer;
+}
+
+uint64_t my_gl::TraceRecorder::now_ns() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+// trace event format, a B and E pair per scope, ts in microseconds
+void my_gl::TraceRecorder::write(std::vector<TraceBuffer*> buffers, std::string path) {
+    std::ofstream file{ path };
+    if (!file) {
+        std::cerr << "can't open trace output " << path << '\n';
+        _is_writing.store(false);
+        return;
+    }
+
+    file << "{\"traceEvents\":[\n";
+    bool is_first{ true };
+    std::vector<TraceEvent> events;
+    events.reserve(TraceBuffer::CAPACITY);
+    uint64_t dropped{ 0 };
+    for (TraceBuffer* buffer : buffers) {
+        if (const char* thread_name{ buffer->_thread_name.load(std::memory_order_relaxed) }) {
+            file << (is_first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->_thread_id
+                << ",\"args\":{\"name\":\"" << thread_name << "\"}}";
+            is_first = false;
+        }
+
+        events.clear();
+        buffer->drain(events);
+        for (const TraceEvent& event : events) {
+            file << (is_first ? "" : ",\n") << "{\"ph\":\"" << (event.is_begin ? 'B' : 'E') << "\",\"pid\":1,\"tid\":" << buffer->_thread_id
+                << ",\"ts\":" << event.timestamp_ns / 1000 << '.' << event.timestamp_ns % 1000 / 100;
+            if (event.is_begin) {
+                file << ",\"name\":\"" << event.name << '"';
+            }
+            file << '}';
+            is_first = false;
+        }
+        dropped += buffer->_dropped.exchange(0, std::memory_order_relaxed);
+    }
+    file << "\n]}\n";
+
+    std::cout << "trace written to " << path;
+    if (dropped > 0) {
+        std::cout << ", " << dropped << " events dropped, buffers were full";
+    }
+    std::cout << '\n';
+    _is_writing.store(false);
+}
+
+my_gl::TraceScope::TraceScope(const char* name) {
+    globals::tracer.begin(name);
+}
+
+my_gl::TraceScope::~TraceScope() {
+    globals::tracer.end();
+}
+#endif
@@ -0,0 +1,20 @@
+#include <cassert>
+#include "glState.hpp"
+#include "uniformBuffer.hpp"
+
+my_gl::UniformBuffer::UniformBuffer(UniformBlock::Binding binding, std::size_t byte_size, GLenum usage)
+    : _byte_size{ byte_size }
+{
+    glCreateBuffers(1, &_id);
+    glNamedBufferData(_id, static_cast<GLsizeiptr>(_byte_size), nullptr, usage);
+    globals::gl_state.bind_buffer_base(GL_UNIFORM_BUFFER, binding, _id);
+}
+
+my_gl::UniformBuffer::~UniformBuffer() {
+    glDeleteBuffers(1, &_id);
+}
+
+void my_gl::UniformBuffer::upload(const void* data, std::size_t byte_size) const {
+    assert(byte_size <= _byte_size && "data doesn't fit the uniform buffer");
+    glNamedBufferSubData(_id, 0, static_cast<GLsizeiptr>(byte_size), data);
+}
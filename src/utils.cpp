@@ -6,6 +6,8 @@
 #include "utils.hpp"
 #include "globals.hpp"
 #include "camera.hpp"
+#include "glState.hpp"
+#include "trace.hpp"
 #include <STB_IMG/stb_image.h>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -18,35 +20,38 @@ my_gl::Window my_gl::init_window() {
     my_gl::Window window{ globals::window_props.width, globals::window_props.height, "nyr_window", nullptr, nullptr };
 
     my_gl::init_GLEW();
+    my_gl::init_gl_state();
 
+    // user input && callbacks
+    glfwSetFramebufferSizeCallback(window.ptr_raw(), my_gl::callback_framebuffer_size);
+    glfwSetKeyCallback(window.ptr_raw(), my_gl::callback_keyboard);
+    glfwSetCursorPosCallback(window.ptr_raw(), my_gl::callback_mouse_move);
+    glfwSetScrollCallback(window.ptr_raw(), my_gl::callback_scroll);
+    glfwSetInputMode(window.ptr_raw(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    return window;
+}
+
+void my_gl::init_gl_state() {
     // error handling
 	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 	glDebugMessageCallback(my_gl::callback_debug_message, NULL);
 
     // culling
-    glEnable(GL_CULL_FACE);
+    globals::gl_state.set_enabled(GL_CULL_FACE, true);
     glCullFace(GL_BACK);
     glFrontFace(GL_CCW);
 
     // depth test
-    glEnable(GL_DEPTH_TEST);
+    globals::gl_state.set_enabled(GL_DEPTH_TEST, true);
     glDepthFunc(GL_LESS);
     glDepthRange(0.0f, 1.0f);
 
-    // user input && callbacks
-    glfwSetFramebufferSizeCallback(window.ptr_raw(), my_gl::callback_framebuffer_size);
-    glfwSetKeyCallback(window.ptr_raw(), my_gl::callback_keyboard);
-    glfwSetCursorPosCallback(window.ptr_raw(), my_gl::callback_mouse_move);
-    glfwSetScrollCallback(window.ptr_raw(), my_gl::callback_scroll);
-    glfwSetInputMode(window.ptr_raw(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
     // points drawing
-    glEnable(GL_PROGRAM_POINT_SIZE);
+    globals::gl_state.set_enabled(GL_PROGRAM_POINT_SIZE, true);
 
     // other
     stbi_set_flip_vertically_on_load(true);
- 
-    return window;
 }
 
 void my_gl::init_GLFW() {
@@ -71,6 +76,7 @@ void my_gl::init_GLEW() {
 }
 
 GLuint my_gl::create_program(const char* vertexShaderFilePath, const char* fragmentShaderFilePath) {
+    MY_GL_TRACE_SCOPE("program link");
     GLuint program{ glCreateProgram() };
 
     GLuint vertexShader{ my_gl::create_shader(GL_VERTEX_SHADER, vertexShaderFilePath) };
@@ -108,6 +114,7 @@ GLuint my_gl::create_program(const char* vertexShaderFilePath, const char* fragm
 
 
 GLuint my_gl::create_shader(GLenum shaderType, const char* filePath) {        
+    MY_GL_TRACE_SCOPE("shader compile");
     std::ifstream shaderFile{ filePath, std::ios_base::binary };
 
     if (!shaderFile.is_open()) {
@@ -161,37 +168,73 @@ void my_gl::callback_framebuffer_size(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);
 }
 
+namespace {
+    // live input is recorded, or ignored while a recorded session plays
+    void handle_input(GLFWwindow* window, const my_gl::InputEvent& event) {
+        switch (my_gl::globals::replay._mode) {
+        case my_gl::ReplayLog::Mode::REPLAY:
+            return;
+        case my_gl::ReplayLog::Mode::RECORD:
+            my_gl::globals::replay.record_event(event);
+            break;
+        default:
+            break;
+        }
+        my_gl::apply_input(window, event);
+    }
+}
+
 void my_gl::callback_keyboard(GLFWwindow* window, int key, int scancode, int action, int mode)
 {
-    switch (key) {
-    case GLFW_KEY_ESCAPE:
-        glfwSetWindowShouldClose(window, GL_TRUE);
-        break;
-    case GLFW_KEY_W:
-        my_gl::globals::camera.process_keyboard_input(my_gl::Camera_movement::FORWARD);
-        break;
-    case GLFW_KEY_S:
-        my_gl::globals::camera.process_keyboard_input(my_gl::Camera_movement::BACKWARD);
-        break;
-    case GLFW_KEY_A:
-        my_gl::globals::camera.process_keyboard_input(my_gl::Camera_movement::LEFT);
-        break;
-    case GLFW_KEY_D:
-        my_gl::globals::camera.process_keyboard_input(my_gl::Camera_movement::RIGHT);
-        break;
+#ifdef MY_GL_TRACING
+    // tooling, not part of the session, so neither recorded nor replayed
+    if (key == GLFW_KEY_F12 && action == GLFW_PRESS) {
+        my_gl::globals::tracer.request_flush();
+        return;
     }
+#endif
+    handle_input(window, my_gl::InputEvent{ .type = my_gl::InputEvent::Type::KEY, .key = key, .action = action });
 }
 
 void my_gl::callback_mouse_move(GLFWwindow *window, double xpos, double ypos) {
-    my_gl::globals::camera.process_mouse_input(
-        static_cast<float>(xpos), static_cast<float>(ypos)
-    );
+    handle_input(window, my_gl::InputEvent{ .type = my_gl::InputEvent::Type::MOUSE_MOVE, .x = static_cast<float>(xpos), .y = static_cast<float>(ypos) });
 }
 
 void my_gl::callback_scroll(GLFWwindow* window, double xoffset, double yoffset) {
-    my_gl::globals::camera.process_scroll_input(
-        static_cast<float>(xoffset), static_cast<float>(yoffset)
-    );
+    handle_input(window, my_gl::InputEvent{ .type = my_gl::InputEvent::Type::SCROLL, .x = static_cast<float>(xoffset), .y = static_cast<float>(yoffset) });
+}
+
+void my_gl::apply_input(GLFWwindow* window, const my_gl::InputEvent& event) {
+    switch (event.type) {
+    case my_gl::InputEvent::Type::KEY:
+        switch (event.key) {
+        case GLFW_KEY_ESCAPE:
+            // headless runs have no window, they stop after their frames
+            if (window) {
+                glfwSetWindowShouldClose(window, GL_TRUE);
+            }
+            break;
+        case GLFW_KEY_W:
+            my_gl::globals::camera.process_keyboard_input(my_gl::Camera_movement::FORWARD);
+            break;
+        case GLFW_KEY_S:
+            my_gl::globals::camera.process_keyboard_input(my_gl::Camera_movement::BACKWARD);
+            break;
+        case GLFW_KEY_A:
+            my_gl::globals::camera.process_keyboard_input(my_gl::Camera_movement::LEFT);
+            break;
+        case GLFW_KEY_D:
+            my_gl::globals::camera.process_keyboard_input(my_gl::Camera_movement::RIGHT);
+            break;
+        }
+        break;
+    case my_gl::InputEvent::Type::MOUSE_MOVE:
+        my_gl::globals::camera.process_mouse_input(event.x, event.y);
+        break;
+    case my_gl::InputEvent::Type::SCROLL:
+        my_gl::globals::camera.process_scroll_input(event.x, event.y);
+        break;
+    }
 }
 
 void my_gl::callback_debug_message(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* msg, const void* data) {